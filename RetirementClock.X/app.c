@@ -0,0 +1,571 @@
+/* 
+ * File: app.c
+ * RetirementClock logic, see app.h.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "app.h"
+#include "hal.h"
+#include "lcd.h"
+#include "serial.h"
+#include "commands.h"
+#include "format.h"
+#include "clock.h"
+#include "bigfont.h"
+#include "font.h"
+#include "profile.h"
+
+// Function prototypes
+uint8_t retirement_reached(void);
+void display_clock(void);
+void display_countdown(void);
+void display_runtime(void);
+void display_bigclock(void);
+static inline void increment_runtime(void);
+void advance_runtime(uint16_t seconds);
+uint32_t runtime_seconds(void);
+void update_retirement(void);
+char *format_date(char *dst, uint8_t d, uint8_t m, uint16_t y);
+void retire(void);
+
+// Time the clock starts from
+static const datetime_t initial_time = {2020, 12, 31, 23, 59, 55};
+
+// Birthday variables
+uint16_t birth_year = 1965;
+uint8_t birth_month = 12;
+uint8_t birth_day = 31;
+
+// Retirement moment in seconds since the clock epoch, see update_retirement()
+uint32_t retirement_epoch;
+
+/*
+ * Keeps track of the system runtime. Kept broken down so the display needs
+ * no 32-bit divisions, runtime_seconds() gives the total when needed.
+ */
+typedef struct
+{
+    uint16_t days;
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+} runtime_t;
+
+runtime_t runtime;
+
+// Keeps track of the current lcd mode (LCD_MODES possible ones)
+uint8_t lcd_mode = 0;
+
+// Serial command being built. Kept between received bytes
+static char command_line[MAX_COMMAND_LEN + 1];
+// Number of characters in the command so far
+static uint8_t command_len = 0;
+// Set when the command didn't fit and the rest of the line is ignored
+static uint8_t command_overflow = 0;
+
+void app_init(void)
+{
+    clock_set(&initial_time);
+    update_retirement();
+    // The big clock's characters stay in CGRAM from here on
+    bigfont_init();
+}
+
+void app_advance(uint16_t seconds)
+{
+    advance_runtime(seconds);
+    clock_advance(seconds);
+}
+
+void app_next_view(void)
+{
+    lcd_mode = ((lcd_mode + 1) % LCD_MODES);
+}
+
+// Builds command lines from received bytes and executes complete ones
+uint8_t serial_task(void)
+{
+    char c;
+    uint8_t executed = 0;
+    
+    while (USART0_read(&c))
+    {
+        // PuTTY console ends lines with '\r' when enter is pressed
+        if (c == '\r')
+        {
+            if (command_overflow)
+            {
+                USART0_sendString("Command too long.\r\n");
+            }
+            else
+            {
+                command_line[command_len] = '\0';
+                execute_command(command_line);
+                executed = 1;
+            }
+            command_len = 0;
+            command_overflow = 0;
+        }
+        else if (c != '\n')
+        {
+            // Build the command array, ignoring the rest of a too long line
+            if (command_len < MAX_COMMAND_LEN)
+            {
+                command_line[command_len++] = c;
+            }
+            else
+            {
+                command_overflow = 1;
+            }
+        }
+    }
+    return executed;
+}
+
+// Seconds until the displayed content next changes
+uint16_t next_wakeup(void)
+{
+    uint32_t now = clock_get_epoch();
+    uint32_t seconds;
+    
+    // Nothing on the retirement screen changes anymore
+    if (now >= retirement_epoch)
+    {
+        return RTC_MAX_SLEEP;
+    }
+    if (lcd_mode == 1)
+    {
+        // Countdown only changes at midnight
+        datetime_t dt;
+        
+        clock_get(&dt);
+        seconds = 86400UL - ((uint32_t)dt.hour * 3600) 
+                - ((uint16_t)dt.minute * 60) - dt.second;
+    }
+    else if (lcd_mode == 3)
+    {
+        // Big clock only shows minutes
+        datetime_t dt;
+        
+        clock_get(&dt);
+        seconds = 60 - dt.second;
+    }
+    else
+    {
+        // Clock and runtime views show seconds
+        seconds = 1;
+    }
+    // Also wake at the moment of retirement
+    if (seconds > retirement_epoch - now)
+    {
+        seconds = retirement_epoch - now;
+    }
+    if (seconds > RTC_MAX_SLEEP)
+    {
+        seconds = RTC_MAX_SLEEP;
+    }
+    return seconds;
+}
+
+// Computes the retirement moment from the birthday
+void update_retirement(void)
+{
+    // Birthdays on February 29th fall on March 1st in other years
+    datetime_t retirement = {birth_year + RETIREMENT_AGE, birth_month, 
+            birth_day, 0, 0, 0};
+    
+    if (retirement.year < CLOCK_EPOCH_YEAR)
+    {
+        retirement_epoch = 0;
+    }
+    else if (retirement.year > CLOCK_MAX_YEAR)
+    {
+        retirement_epoch = UINT32_MAX;
+    }
+    else
+    {
+        retirement_epoch = civil_to_epoch(&retirement);
+    }
+}
+
+// Check if it's time to retire
+uint8_t retirement_reached(void)
+{
+    return clock_get_epoch() >= retirement_epoch;
+}
+
+// Updates the LCD. Called from the superloop, never from an ISR
+void render(void)
+{
+    // Show the retirement message instead of the time
+    if (retirement_reached())
+    {
+        retire();
+    }
+    else
+    {
+        // Turn buzzer off
+        hal_buzzer(0);
+        // Draw the appropriate time showing view into the framebuffer
+        switch (lcd_mode)
+        {
+            case 0:
+                display_clock();
+                break;
+            case 1:
+                display_countdown();
+                break;
+            case 2:
+                display_runtime();
+                break;       
+            case 3:
+                display_bigclock();
+                break;
+        }
+    }
+    // Send only the characters that changed to the LCD
+    lcd_flush();
+}
+
+// Writes a date as d.m.yyyy and returns a pointer past it
+char *format_date(char *dst, uint8_t d, uint8_t m, uint16_t y)
+{
+    dst = fmt_u32(dst, d);
+    *dst++ = '.';
+    dst = fmt_u32(dst, m);
+    *dst++ = '.';
+    return fmt_u16_4(dst, y);
+}
+
+// Displays a time and date view
+void display_clock(void)
+{
+    // Holds time and date text for both rows
+    char buffer[2 * LCD_DISP_LENGTH + 2];
+    char *p = buffer;
+    datetime_t now;
+    
+    PROFILE_ENTER(PROF_DISPLAY_CLOCK);
+    clock_get(&now);
+    // Display time on top row, hh:mm:ss
+    p = fmt_u8_2(p, now.hour);
+    *p++ = ':';
+    p = fmt_u8_2(p, now.minute);
+    *p++ = ':';
+    p = fmt_u8_2(p, now.second);
+    // Move cursor to next row
+    *p++ = '\n';
+    // Display date on bottom row
+    p = format_date(p, now.day, now.month, now.year);
+    *p = '\0';
+    
+    // Clear the framebuffer
+    lcd_fb_clear();
+    lcd_fb_puts(buffer);
+    PROFILE_EXIT(PROF_DISPLAY_CLOCK);
+}
+
+// Displays retirement date and the number of days left until it
+void display_countdown(void)
+{
+    PROFILE_ENTER(PROF_DISPLAY_COUNTDOWN);
+    // Holds the date and the days left
+    char buffer[LCD_DISP_LENGTH + 1];
+    // Retirement is at midnight, so a started day counts as a whole one
+    uint32_t days = (retirement_epoch - clock_get_epoch() + 86399) / 86400;
+    
+    // Clear the framebuffer
+    lcd_fb_clear();
+    *format_date(buffer, birth_day, birth_month,
+            birth_year + RETIREMENT_AGE) = '\0';
+    lcd_fb_puts(buffer);
+    lcd_fb_putc('\n');
+    *fmt_u32(buffer, days) = '\0';
+    lcd_fb_puts(buffer);
+    lcd_fb_puts(" days left");
+    PROFILE_EXIT(PROF_DISPLAY_COUNTDOWN);
+}
+
+// Display how long the system has been running
+void display_runtime(void)
+{
+    // Holds days:hours:minutes:seconds
+    char buffer[LCD_DISP_LENGTH + 1];
+    char *p = buffer;
+    runtime_t now;
+    
+    PROFILE_ENTER(PROF_DISPLAY_RUNTIME);
+    now = runtime;
+    
+    p = fmt_u32(p, now.days);
+    *p++ = ':';
+    p = fmt_u32(p, now.hours);
+    *p++ = ':';
+    p = fmt_u32(p, now.minutes);
+    *p++ = ':';
+    p = fmt_u32(p, now.seconds);
+    *p = '\0';
+    
+    // Clear the framebuffer
+    lcd_fb_clear();
+    lcd_fb_puts(buffer);
+    lcd_fb_puts("\nSystem runtime");
+    PROFILE_EXIT(PROF_DISPLAY_RUNTIME);
+}
+
+/*
+ * Displays the time as hh:mm in digits two rows high. Only the digits that
+ * changed since the last minute differ from what the LCD already shows.
+ */
+void display_bigclock(void)
+{
+    datetime_t now;
+    
+    PROFILE_ENTER(PROF_DISPLAY_BIGCLOCK);
+    clock_get(&now);
+    lcd_fb_clear();
+    bigfont_fb_digit(0, now.hour / 10);
+    bigfont_fb_digit(BIGFONT_WIDTH + 1, now.hour % 10);
+    bigfont_fb_colon(2 * BIGFONT_WIDTH + 1);
+    bigfont_fb_digit(2 * BIGFONT_WIDTH + 2, now.minute / 10);
+    bigfont_fb_digit(3 * BIGFONT_WIDTH + 3, now.minute % 10);
+    PROFILE_EXIT(PROF_DISPLAY_BIGCLOCK);
+}
+
+// Advances the runtime by a second, carrying into minutes, hours and days
+static inline void increment_runtime(void)
+{
+    if (++runtime.seconds < 60)
+    {
+        return;
+    }
+    runtime.seconds = 0;
+    if (++runtime.minutes < 60)
+    {
+        return;
+    }
+    runtime.minutes = 0;
+    if (++runtime.hours < 24)
+    {
+        return;
+    }
+    runtime.hours = 0;
+    runtime.days++;
+}
+
+// Advances the runtime by any number of seconds
+void advance_runtime(uint16_t seconds)
+{
+    uint16_t carry;
+    
+    // One second is cheapest to carry, longer gaps are divided up
+    if (seconds == 1)
+    {
+        increment_runtime();
+        return;
+    }
+    seconds += runtime.seconds;
+    carry = seconds / 60;
+    runtime.seconds = seconds - (carry * 60);
+    carry += runtime.minutes;
+    seconds = carry / 60;
+    runtime.minutes = carry - (seconds * 60);
+    seconds += runtime.hours;
+    carry = seconds / 24;
+    runtime.hours = seconds - (carry * 24);
+    runtime.days += carry;
+}
+
+// Total system runtime in seconds
+uint32_t runtime_seconds(void)
+{
+    runtime_t now;
+    
+    now = runtime;
+    return ((uint32_t)now.days * 86400) + ((uint32_t)now.hours * 3600)
+            + (now.minutes * 60) + now.seconds;
+}
+
+void retire(void)
+{
+    lcd_fb_clear();
+    
+    lcd_fb_gotoxy(2,0);
+    font_fb_puts(FONT_BELL " Go home! " FONT_BELL);
+    
+    // "Hyvää eläkettä!", happy retirement in Finnish
+    lcd_fb_gotoxy(0,1);
+    font_fb_puts("Hyv\xE4\xE4 el\xE4kett\xE4!");
+    hal_buzzer(1);
+}
+
+// Check that day exists in the given month, taking leap years into account
+static uint8_t valid_date(uint8_t d, uint8_t m, uint16_t y)
+{
+    return d <= clock_days_in_month(m, y);
+}
+
+/*
+ * Set date and time.
+ * Syntax is "SET DATETIME dd mm yyyy hh mm ss".
+ */
+static uint8_t cmd_set_datetime(const uint16_t *args)
+{
+    if (!valid_date(args[0], args[1], args[2]))
+    {
+        return COMMAND_BAD_ARGS;
+    }
+    datetime_t dt = {args[2], args[1], args[0], args[3], args[4], args[5]};
+    
+    clock_set(&dt);
+    return COMMAND_OK;
+}
+
+// Print date and time in the serial console
+static uint8_t cmd_get_datetime(const uint16_t *args)
+{
+    char buffer[33];
+    char *p = buffer;
+    datetime_t now;
+    
+    clock_get(&now);
+    p = format_date(p, now.day, now.month, now.year);
+    *p++ = ' ';
+    p = fmt_u32(p, now.hour);
+    *p++ = ':';
+    p = fmt_u32(p, now.minute);
+    *p++ = ':';
+    p = fmt_u32(p, now.second);
+    *p = '\0';
+    
+    USART0_sendString(buffer);
+    USART0_sendString("\r\n");
+    return COMMAND_OK;
+}
+
+/*
+ * Set birthday.
+ * Syntax is "SET BIRTHDAY dd mm yyyy".
+ */
+static uint8_t cmd_set_birthday(const uint16_t *args)
+{
+    if (!valid_date(args[0], args[1], args[2]))
+    {
+        return COMMAND_BAD_ARGS;
+    }
+    birth_day = args[0];
+    birth_month = args[1];
+    birth_year = args[2];
+    update_retirement();
+    return COMMAND_OK;
+}
+
+// Print birthday to the serial console
+static uint8_t cmd_get_birthday(const uint16_t *args)
+{
+    char buffer[33];
+    char *p = format_date(buffer, birth_day, birth_month, birth_year);
+    
+    *p = '\0';
+    USART0_sendString(buffer);
+    USART0_sendString("\r\n");
+    return COMMAND_OK;
+}
+
+// Print the number of received bytes lost to buffer overruns
+static uint8_t cmd_get_rxstats(const uint16_t *args)
+{
+    char buffer[33];
+    char *p = fmt_u32(buffer, USART0_rxDropped());
+    
+    *p = '\0';
+    USART0_sendString("RX DROPPED: ");
+    USART0_sendString(buffer);
+    USART0_sendString("\r\n");
+    return COMMAND_OK;
+}
+
+// Print how often the LCD glyph cache found a custom character in CGRAM
+static uint8_t cmd_get_glyphs(const uint16_t *args)
+{
+    char buffer[33];
+    char *p;
+    
+    p = fmt_u32(buffer, lcd_glyph_hits());
+    *p = '\0';
+    USART0_sendString("GLYPH HITS: ");
+    USART0_sendString(buffer);
+    p = fmt_u32(buffer, lcd_glyph_misses());
+    *p = '\0';
+    USART0_sendString(" MISSES: ");
+    USART0_sendString(buffer);
+    USART0_sendString("\r\n");
+    return COMMAND_OK;
+}
+
+// Print the system runtime in seconds
+static uint8_t cmd_get_runtime(const uint16_t *args)
+{
+    char buffer[11];
+    
+    *fmt_u32(buffer, runtime_seconds()) = '\0';
+    USART0_sendString("RUNTIME: ");
+    USART0_sendString(buffer);
+    USART0_sendString(" s\r\n");
+    return COMMAND_OK;
+}
+
+// Toggle the LED backlight bits
+static uint8_t cmd_tgl_backlight(const uint16_t *args)
+{
+    hal_backlight_toggle();
+    USART0_sendString("BACKLIGHT TOGGLED.\r\n");
+    return COMMAND_OK;
+}
+
+#if PROFILE
+// Print the cycle counts of the profiled regions
+static uint8_t cmd_get_profile(const uint16_t *args)
+{
+    profile_dump();
+    return COMMAND_OK;
+}
+#endif
+
+// Serial commands with their argument ranges, sorted by name
+static const command_t commands[] PROGMEM =
+{
+    {"GET BIRTHDAY", cmd_get_birthday, 0, {{0}}},
+    {"GET DATETIME", cmd_get_datetime, 0, {{0}}},
+    {"GET GLYPHS", cmd_get_glyphs, 0, {{0}}},
+#if PROFILE
+    {"GET PROFILE", cmd_get_profile, 0, {{0}}},
+#endif
+    {"GET RUNTIME", cmd_get_runtime, 0, {{0}}},
+    {"GET RXSTATS", cmd_get_rxstats, 0, {{0}}},
+    // The retirement date has to fit the clock to be shown
+    {"SET BIRTHDAY", cmd_set_birthday, 3,
+        {{1, 31}, {1, 12}, {1900, CLOCK_MAX_YEAR - RETIREMENT_AGE}}},
+    {"SET DATETIME", cmd_set_datetime, 6,
+        {{1, 31}, {1, 12}, {CLOCK_EPOCH_YEAR, CLOCK_MAX_YEAR},
+         {0, 23}, {0, 59}, {0, 59}}},
+    {"TGL BACKLIGHT", cmd_tgl_backlight, 0, {{0}}},
+};
+
+// Execute serial terminal commands
+void execute_command(const char *command)
+{
+    PROFILE_ENTER(PROF_EXECUTE_COMMAND);
+    switch (command_execute(command, commands,
+            sizeof(commands) / sizeof(commands[0])))
+    {
+        case COMMAND_UNKNOWN:
+            USART0_sendString("Incorrect command.\r\n");
+            break;
+        case COMMAND_BAD_ARGS:
+            USART0_sendString("Incorrect arguments.\r\n");
+            break;
+    }
+    PROFILE_EXIT(PROF_EXECUTE_COMMAND);
+}
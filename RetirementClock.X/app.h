@@ -0,0 +1,39 @@
+/* 
+ * File: app.h
+ * RetirementClock logic: time and retirement bookkeeping, the LCD views
+ * and the serial commands.
+ * 
+ * Nothing here touches hardware registers. Outputs go through hal.h, the
+ * display through lcd.h and the console through serial.h, so the same code
+ * runs on the board (main.c) and in the host simulator (host/).
+ */
+
+#ifndef APP_H
+#define APP_H
+
+#include <stdint.h>
+
+#define MAX_COMMAND_LEN 32 // Max serial command length
+#define RETIREMENT_AGE 65
+#define RTC_MAX_SLEEP 0x7FFF // Longest RTC sleep in seconds, below counter wrap
+#define LCD_MODES 4 // Clock, retirement countdown, runtime and big clock views
+
+// Start the clock from the initial time and work out when to retire
+void app_init(void);
+// Advance the time, date and runtime by the given number of seconds
+void app_advance(uint16_t seconds);
+// Switch the LCD to the next view
+void app_next_view(void);
+// Draw the current view and update the LCD
+void render(void);
+// Seconds until the displayed content next changes
+uint16_t next_wakeup(void);
+/*
+ * Builds command lines from received bytes and executes complete ones.
+ * Returns 1 if a command was executed.
+ */
+uint8_t serial_task(void);
+// Execute one serial command line
+void execute_command(const char *command);
+
+#endif // APP_H
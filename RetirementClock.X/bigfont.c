@@ -0,0 +1,90 @@
+/* 
+ * File: bigfont.c
+ * Two row digits, see bigfont.h.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "bigfont.h"
+#include "lcd.h"
+
+#if !LCD_GLYPH_CACHE
+#error "bigfont.c needs LCD_GLYPH_CACHE set in lcd.h"
+#endif
+
+// Segment characters, index into glyphs[]
+#define LT 0    // Upper left corner
+#define UB 1    // Upper bar
+#define RT 2    // Upper right corner
+#define LL 3    // Lower left corner
+#define LB 4    // Lower bar
+#define LR 5    // Lower right corner
+#define UM 6    // Upper bar and the top of the middle bar
+#define LM 7    // Bottom of the middle bar and lower bar
+// Characters from the ROM, codes above the segment numbers
+#define FULL ((char)0xFF)   // Full block in the character ROM
+#define DOT ((char)0xA5)    // Centered dot in the character ROM
+
+static const uint8_t glyphs[8][8] PROGMEM =
+{
+    {0x07, 0x0F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},    // LT
+    {0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00},    // UB
+    {0x1C, 0x1E, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},    // RT
+    {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x0F, 0x07},    // LL
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},    // LB
+    {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1E, 0x1C},    // LR
+    {0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x1F, 0x1F},    // UM
+    {0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},    // LM
+};
+
+// Top row then bottom row of each digit, segments or ROM characters
+static const char digits[10][2 * BIGFONT_WIDTH] PROGMEM =
+{
+    {LT,   UB,   RT,     LL,   LB,   LR},   // 0
+    {UB,   RT,   ' ',    LB,   FULL, LB},   // 1
+    {UM,   UM,   RT,     LL,   LM,   LM},   // 2
+    {UM,   UM,   RT,     LM,   LM,   LR},   // 3
+    {LL,   LB,   FULL,   ' ',  ' ',  FULL}, // 4
+    {FULL, UM,   UM,     LM,   LM,   LR},   // 5
+    {LT,   UM,   UM,     LL,   LM,   LR},   // 6
+    {UB,   UB,   RT,     ' ',  ' ',  FULL}, // 7
+    {LT,   UM,   RT,     LL,   LM,   LR},   // 8
+    {LT,   UM,   RT,     LM,   LM,   LR},   // 9
+};
+
+void bigfont_init(void)
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        lcd_glyph(glyphs[i]);
+    }
+}
+
+void bigfont_fb_digit(uint8_t x, uint8_t digit)
+{
+    const char *p = digits[digit];
+    
+    for (uint8_t y = 0; y < 2; y++)
+    {
+        lcd_fb_gotoxy(x, y);
+        for (uint8_t i = 0; i < BIGFONT_WIDTH; i++)
+        {
+            char c = pgm_read_byte(p++);
+            
+            // Segments are looked up every time, the cache keeps them recent
+            if ((uint8_t)c < 8)
+            {
+                c = lcd_glyph(glyphs[(uint8_t)c]);
+            }
+            lcd_fb_putc(c);
+        }
+    }
+}
+
+void bigfont_fb_colon(uint8_t x)
+{
+    lcd_fb_gotoxy(x, 0);
+    lcd_fb_putc(DOT);
+    lcd_fb_gotoxy(x, 1);
+    lcd_fb_putc(DOT);
+}
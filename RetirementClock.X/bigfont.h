@@ -0,0 +1,26 @@
+/* 
+ * File: bigfont.h
+ * Digits two LCD rows high and three columns wide, built from eight
+ * custom characters and the full block of the character ROM.
+ * 
+ * The custom characters go through the glyph cache of lcd.c. bigfont_init()
+ * loads them all, after that they are reloaded only if other custom
+ * characters took their slots. The digits are drawn into the LCD
+ * framebuffer, so lcd_flush() only sends the cells of digits that changed.
+ */
+
+#ifndef BIGFONT_H
+#define BIGFONT_H
+
+#include <stdint.h>
+
+#define BIGFONT_WIDTH 3 // Columns taken by a digit
+
+// Load the segment characters into CGRAM
+void bigfont_init(void);
+// Draw a digit (0-9) into the framebuffer with its top left at column x
+void bigfont_fb_digit(uint8_t x, uint8_t digit);
+// Draw a colon over both rows into column x of the framebuffer
+void bigfont_fb_colon(uint8_t x);
+
+#endif // BIGFONT_H
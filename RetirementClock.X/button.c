@@ -0,0 +1,130 @@
+/* 
+ * File: button.c
+ * Debounced button on PF6, see button.h.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "button.h"
+#include "events.h"
+#include "profile.h"
+
+// Debounced state, nonzero when held down
+static volatile uint8_t pressed = 0;
+// Samples in a row that differed from the debounced state
+static uint8_t debounce = 0;
+// Ticks held since the press or the last long/repeat event
+static uint8_t hold = 0;
+// Set once the long press event has been sent for this press
+static uint8_t long_sent = 0;
+
+static void sampling_start(void);
+static void sampling_stop(void);
+static inline void sample(void);
+
+void button_init(void)
+{
+    // Set button as input
+    PORTF.DIRCLR = PIN6_bm;
+    // Btn triggers an interrupt on falling edge
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_FALLING_gc;
+}
+
+uint8_t button_held(void)
+{
+    return pressed;
+}
+
+// Hand the pin over from the edge interrupt to the PIT
+static void sampling_start(void)
+{
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_INTDISABLE_gc;
+    
+    while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+    RTC.PITINTFLAGS = RTC_PI_bm;
+    RTC.PITINTCTRL = RTC_PI_bm;
+    RTC.PITCTRLA = RTC_PERIOD_CYC256_gc | RTC_PITEN_bm;
+}
+
+// Back to waiting for a press without any periodic wakeups
+static void sampling_stop(void)
+{
+    while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+    RTC.PITCTRLA = 0;
+    RTC.PITINTCTRL = 0;
+    
+    PORTF.INTFLAGS = PIN6_bm;
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_FALLING_gc;
+    
+    // A press while the edge interrupt was off has no edge left to see
+    if (!(VPORTF.IN & PIN6_bm))
+    {
+        sampling_start();
+    }
+}
+
+// Triggered on a button press, possibly by contact bounce
+ISR(PORTF_PORT_vect)
+{
+    PROFILE_ENTER(PROF_ISR_PORTF);
+    // Clear the interrupt flag
+    PORTF.INTFLAGS = PIN6_bm;
+    sampling_start();
+    PROFILE_EXIT(PROF_ISR_PORTF);
+}
+
+// Button sample tick while the button is in use
+ISR(RTC_PIT_vect)
+{
+    PROFILE_ENTER(PROF_ISR_RTC_PIT);
+    RTC.PITINTFLAGS = RTC_PI_bm;
+    sample();
+    PROFILE_EXIT(PROF_ISR_RTC_PIT);
+}
+
+// Debounce one sample and post the resulting events
+static inline void sample(void)
+{
+    // Btn pulls the pin low
+    uint8_t level = !(VPORTF.IN & PIN6_bm);
+    
+    if (level != pressed)
+    {
+        // Wait for the level to settle before accepting the change
+        if (++debounce < BUTTON_DEBOUNCE_TICKS)
+        {
+            return;
+        }
+        pressed = level;
+        hold = 0;
+        
+        // A press that didn't become a long press is a click
+        if (!pressed && !long_sent)
+        {
+            event_post(EVENT_BUTTON_CLICK);
+        }
+        long_sent = 0;
+    }
+    debounce = 0;
+    
+    if (pressed)
+    {
+        ++hold;
+        if (!long_sent && hold >= BUTTON_LONG_TICKS)
+        {
+            event_post(EVENT_BUTTON_LONG);
+            long_sent = 1;
+            hold = 0;
+        }
+        else if (long_sent && hold >= BUTTON_REPEAT_TICKS)
+        {
+            event_post(EVENT_BUTTON_REPEAT);
+            hold = 0;
+        }
+    }
+    else
+    {
+        // Released and settled, or the edge was only a glitch
+        sampling_stop();
+    }
+}
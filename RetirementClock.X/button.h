@@ -0,0 +1,39 @@
+/* 
+ * File: button.h
+ * Debounced button on PF6.
+ * 
+ * A falling edge on the pin starts sampling it with the RTC PIT, which
+ * runs from the RTC clock in every sleep mode. The level must read the
+ * same for BUTTON_DEBOUNCE_TICKS samples to count as a press or release.
+ * Once released, the PIT is stopped and the pin interrupt waits for the
+ * next press, so nothing runs while the button isn't touched.
+ * 
+ * Events posted to the superloop:
+ *   EVENT_BUTTON_CLICK   released before BUTTON_LONG_TICKS
+ *   EVENT_BUTTON_LONG    held for BUTTON_LONG_TICKS, no click follows
+ *   EVENT_BUTTON_REPEAT  every BUTTON_REPEAT_TICKS while still held
+ */
+
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+
+// Sample rate: RTC clock / 256 = 128 Hz, 7.8 ms per tick
+#define BUTTON_TICK_HZ          128
+// Ticks the level must be stable for, ~23 ms
+#define BUTTON_DEBOUNCE_TICKS   3
+// Ticks until a long press, ~0.75 s
+#define BUTTON_LONG_TICKS       96
+// Ticks between repeats after a long press, ~0.5 s
+#define BUTTON_REPEAT_TICKS     64
+
+/*
+ * Set PF6 up as the button input. The PIT uses the clock selected in
+ * RTC.CLKSEL and doesn't need the RTC counter to be enabled.
+ */
+void button_init(void);
+// Nonzero while the debounced button is held down
+uint8_t button_held(void);
+
+#endif // BUTTON_H
@@ -0,0 +1,184 @@
+/* 
+ * File: clock.c
+ * Time keeping core. Implements leap years and the conversions between
+ * broken down time and seconds since the epoch.
+ */
+
+#include <stdint.h>
+#include "clock.h"
+
+/*
+ * The conversions count days from 1.3.1600. Starting the year in March puts
+ * the leap day last, and 1600 starts a 400 year leap cycle just like 2000.
+ */
+#define DAYS_FROM_1600_TO_EPOCH 146037UL    // 1.3.1600 to 1.1.2000
+#define DAYS_IN_400_YEARS       146097UL
+#define SECONDS_PER_DAY         86400UL
+
+static inline void increment_minute(void);
+static inline void increment_hour(void);
+static inline void increment_day(void);
+static inline void increment_month(void);
+
+// Seconds since the epoch
+static uint32_t clock_epoch;
+// The same time broken down, kept in step with clock_epoch
+static datetime_t clock_now;
+
+// Holds the number of days in each month
+static const uint8_t days_in_month[] = {31,28,31,30,31,30,31,31,30,31,30,31};
+
+uint8_t clock_is_leap_year(uint16_t year)
+{
+    return (((year % 400) == 0) || ((year % 100) != 0)) && ((year % 4) == 0);
+}
+
+uint8_t clock_days_in_month(uint8_t month, uint16_t year)
+{
+    if ((month == 2) && clock_is_leap_year(year))
+    {
+        return 29;
+    }
+    return days_in_month[month - 1];
+}
+
+uint32_t civil_to_epoch(const datetime_t *dt)
+{
+    // Years and months counted from March, January and February come last
+    uint16_t y = dt->year - 1600 - (dt->month <= 2);
+    uint8_t m = (dt->month > 2) ? (dt->month - 3) : (dt->month + 9);
+    // Day of the March based year. 153 days in every 5 months from March
+    uint16_t doy = (153 * m + 2) / 5 + dt->day - 1;
+    uint32_t days = (uint32_t)y * 365 + (y / 4) - (y / 100) + (y / 400) + doy;
+    
+    days -= DAYS_FROM_1600_TO_EPOCH;
+    return (days * SECONDS_PER_DAY) + ((uint32_t)dt->hour * 3600)
+            + ((uint16_t)dt->minute * 60) + dt->second;
+}
+
+void epoch_to_civil(uint32_t epoch, datetime_t *dt)
+{
+    uint32_t days = epoch / SECONDS_PER_DAY;
+    uint32_t secs = epoch - (days * SECONDS_PER_DAY);
+    
+    dt->hour = secs / 3600;
+    secs -= (uint32_t)dt->hour * 3600;
+    dt->minute = (uint16_t)secs / 60;
+    dt->second = (uint16_t)secs - (dt->minute * 60);
+    
+    days += DAYS_FROM_1600_TO_EPOCH;
+    uint16_t era = days / DAYS_IN_400_YEARS;
+    // Day and year of the 400 year era, leap days corrected away
+    uint32_t doe = days - (era * DAYS_IN_400_YEARS);
+    uint16_t yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+    uint16_t doy = doe - ((uint32_t)yoe * 365 + (yoe / 4) - (yoe / 100));
+    uint8_t mp = (5 * doy + 2) / 153;
+    
+    dt->day = doy - ((153 * mp + 2) / 5) + 1;
+    dt->month = (mp < 10) ? (mp + 3) : (mp - 9);
+    dt->year = 1600 + (era * 400) + yoe + (dt->month <= 2);
+}
+
+/* Time and date incrementation functions.
+ * As the seconds are about to "overflow" to 60,
+ * they are reset to 0 and increment_minute() is called. 
+ * This method is repeated up to year increments
+ */
+void clock_tick(void)
+{
+    clock_epoch++;
+    if (clock_now.second == 59)
+    {
+        clock_now.second = 0;
+        increment_minute();
+    }
+    else
+    {
+        clock_now.second++;
+    }
+}
+
+void clock_advance(uint32_t seconds)
+{
+    // One second is cheapest to carry, longer gaps are converted
+    if (seconds == 1)
+    {
+        clock_tick();
+    }
+    else if (seconds)
+    {
+        datetime_t now;
+        
+        clock_epoch += seconds;
+        epoch_to_civil(clock_epoch, &now);
+        clock_now = now;
+    }
+}
+
+static inline void increment_minute(void)
+{
+    if (clock_now.minute == 59)
+    {
+        clock_now.minute = 0;
+        increment_hour();
+    }
+    else
+    {
+        clock_now.minute++;
+    }
+}
+
+static inline void increment_hour(void)
+{
+    if (clock_now.hour == 23)
+    {
+        clock_now.hour = 0;
+        increment_day();
+    }
+    else
+    {
+        clock_now.hour++;
+    }
+}
+
+static inline void increment_day(void)
+{
+    if (clock_now.day >= clock_days_in_month(clock_now.month, clock_now.year))
+    {
+        clock_now.day = 1;
+        increment_month();
+    }
+    else
+    {
+        clock_now.day++;
+    } 
+}
+
+static inline void increment_month(void)
+{
+    if (clock_now.month == 12)
+    {
+        clock_now.month = 1;
+        clock_now.year++;
+    }
+    else
+    {
+        clock_now.month++;
+    }
+}
+
+void clock_set(const datetime_t *dt)
+{
+    clock_epoch = civil_to_epoch(dt);
+    clock_now = *dt;
+}
+
+void clock_get(datetime_t *dt)
+{
+    *dt = clock_now;
+}
+
+uint32_t clock_get_epoch(void)
+{
+    return clock_epoch;
+}
@@ -0,0 +1,49 @@
+/* 
+ * File: clock.h
+ * Time keeping core. The current time is a single count of seconds since
+ * 1.1.2000 00:00:00 (the epoch), plus a broken down copy of it that is
+ * carried forward every second so the display never has to convert.
+ * Conversions between the two are only needed when the time is set.
+ * Valid from 1.1.2000 until 7.2.2136.
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+#define CLOCK_EPOCH_YEAR 2000
+#define CLOCK_MAX_YEAR 2135    // Last full year that fits the seconds counter
+
+// Broken down date and time
+typedef struct
+{
+    uint16_t year;
+    uint8_t month;      // 1-12
+    uint8_t day;        // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+} datetime_t;
+
+uint8_t clock_is_leap_year(uint16_t year);
+uint8_t clock_days_in_month(uint8_t month, uint16_t year);
+
+// Conversions between broken down time and seconds since the epoch
+uint32_t civil_to_epoch(const datetime_t *dt);
+void epoch_to_civil(uint32_t epoch, datetime_t *dt);
+
+/*
+ * Advance the clock by one second or by any number of seconds. Only used
+ * in main context, where rtc_sync() catches up with the RTC counter
+ * through app_advance(), so no interrupt touches the clock.
+ */
+void clock_tick(void);
+void clock_advance(uint32_t seconds);
+// Set the clock. dt must be a valid date in the supported range
+void clock_set(const datetime_t *dt);
+// Consistent copies of the current time
+void clock_get(datetime_t *dt);
+uint32_t clock_get_epoch(void);
+
+#endif // CLOCK_H
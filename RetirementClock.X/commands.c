@@ -0,0 +1,122 @@
+/* 
+ * File: commands.c
+ * Table driven serial command dispatcher
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "commands.h"
+
+static int8_t compare_name(const char *line, const char *name);
+static uint8_t parse_uint(const char **str, uint16_t *value);
+
+/*
+ * Order line against a PROGMEM command name like strcmp_P() would order
+ * the name it starts with. Returns 0 when line is the name followed by an
+ * argument or the end of the line.
+ */
+static int8_t compare_name(const char *line, const char *name)
+{
+    uint8_t c;
+    
+    while ((c = pgm_read_byte(name++)) != '\0')
+    {
+        if ((uint8_t)*line != c)
+        {
+            return ((uint8_t)*line < c) ? -1 : 1;
+        }
+        line++;
+    }
+    // The name must be followed by an argument or the end of the line
+    return ((*line == ' ') || (*line == '\0')) ? 0 : 1;
+}
+
+/*
+ * Parse an unsigned decimal number after any spaces and advance *str past
+ * it. Returns 0 if there are no digits or the value doesn't fit 16 bits.
+ */
+static uint8_t parse_uint(const char **str, uint16_t *value)
+{
+    const char *p = *str;
+    uint32_t num = 0;
+    
+    while (*p == ' ')
+    {
+        p++;
+    }
+    if ((*p < '0') || (*p > '9'))
+    {
+        return 0;
+    }
+    while ((*p >= '0') && (*p <= '9'))
+    {
+        num = num * 10 + (*p++ - '0');
+        if (num > UINT16_MAX)
+        {
+            return 0;
+        }
+    }
+    *str = p;
+    *value = num;
+    return 1;
+}
+
+uint8_t command_execute(const char *line, const command_t *table,
+        uint8_t count)
+{
+    const command_t *entry = NULL;
+    uint8_t lo = 0;
+    uint8_t hi = count;
+    
+    // Binary search, the table is sorted by name
+    while (lo < hi)
+    {
+        uint8_t mid = lo + (hi - lo) / 2;
+        int8_t cmp = compare_name(line, table[mid].name);
+        
+        if (cmp == 0)
+        {
+            entry = &table[mid];
+            break;
+        }
+        if (cmp < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    if (entry == NULL)
+    {
+        return COMMAND_UNKNOWN;
+    }
+    
+    command_t command;
+    uint16_t args[COMMAND_MAX_ARGS];
+    const char *p;
+    
+    memcpy_P(&command, entry, sizeof(command));
+    p = line + strlen(command.name);
+    for (uint8_t arg = 0; arg < command.argc; arg++)
+    {
+        if (!parse_uint(&p, &args[arg])
+                || (args[arg] < command.args[arg].min)
+                || (args[arg] > command.args[arg].max))
+        {
+            return COMMAND_BAD_ARGS;
+        }
+    }
+    // Nothing but spaces may follow the last argument
+    while (*p == ' ')
+    {
+        p++;
+    }
+    if (*p != '\0')
+    {
+        return COMMAND_BAD_ARGS;
+    }
+    return command.handler(args);
+}
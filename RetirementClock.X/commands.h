@@ -0,0 +1,54 @@
+/* 
+ * File: commands.h
+ * Table driven serial command dispatcher.
+ * 
+ * Commands are described by a table of command_t entries placed in program
+ * memory. Each entry has the command name, the number of unsigned integer
+ * arguments it takes with an allowed range for each, and a handler that is
+ * called with the parsed arguments once everything has been validated.
+ * 
+ * The table must be sorted by name in strcmp() order, commands are looked
+ * up by binary search. A name followed by a space mustn't start another
+ * name.
+ */
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdint.h>
+
+#define COMMAND_NAME_LEN 14 // Longest command name including the '\0'
+#define COMMAND_MAX_ARGS 6  // Most integer arguments a command can take
+
+// Results of command_execute(), also returned by the handlers
+#define COMMAND_OK          0
+#define COMMAND_UNKNOWN     1 // No command with that name
+#define COMMAND_BAD_ARGS    2 // Missing, extra, malformed or out of range
+
+// Allowed range of an integer argument (inclusive)
+typedef struct
+{
+    uint16_t min;
+    uint16_t max;
+} command_arg_t;
+
+// Handlers get argc validated arguments and return one of the results
+typedef uint8_t (*command_handler_t)(const uint16_t *args);
+
+typedef struct
+{
+    char name[COMMAND_NAME_LEN];
+    command_handler_t handler;
+    uint8_t argc;
+    command_arg_t args[COMMAND_MAX_ARGS];
+} command_t;
+
+/*
+ * Find the command named by the start of line in the sorted PROGMEM table,
+ * parse and range check its arguments in a single pass and call its
+ * handler.
+ */
+uint8_t command_execute(const char *line, const command_t *table,
+        uint8_t count);
+
+#endif // COMMANDS_H
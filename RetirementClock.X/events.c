@@ -0,0 +1,35 @@
+/* 
+ * File: events.c
+ * Event flag handling for the superloop
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "events.h"
+#include "power.h"
+
+volatile uint8_t pending_events = 0;
+
+/*
+ * Sleep until at least one event is pending, then return and clear all
+ * pending events. Interrupts are disabled while checking the flags and 
+ * power_sleep() enables them right before sleeping, so an event posted
+ * between the check and the sleep still wakes us up.
+ */
+uint8_t events_wait(void)
+{
+    uint8_t events;
+    
+    while (1)
+    {
+        cli();
+        events = pending_events;
+        if (events)
+        {
+            pending_events = 0;
+            sei();
+            return events;
+        }
+        power_sleep();
+    }
+}
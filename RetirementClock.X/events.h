@@ -0,0 +1,37 @@
+/* 
+ * File: events.h
+ * Event flags posted by interrupt handlers and drained by the superloop.
+ * ISRs only record that something happened; all the slow work (LCD
+ * rendering, command handling) is done in main context.
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+// Event flags. One bit each, several may be pending at once
+#define EVENT_TICK              (1 << 0)   // RTC wakeup, shown time may have changed
+#define EVENT_BUTTON_CLICK      (1 << 1)   // Button pressed and released
+#define EVENT_SERIAL            (1 << 2)   // USART0 byte received
+#define EVENT_BUTTON_LONG       (1 << 3)   // Button held down
+#define EVENT_BUTTON_REPEAT     (1 << 4)   // Button still held after a long press
+
+// Any button event
+#define EVENT_BUTTON    (EVENT_BUTTON_CLICK | EVENT_BUTTON_LONG | EVENT_BUTTON_REPEAT)
+
+// Pending events. Written by ISRs, read and cleared by events_wait()
+extern volatile uint8_t pending_events;
+
+/*
+ * Post an event from an ISR. Interrupts are already disabled inside an
+ * ISR, so the read-modify-write is safe there without further locking.
+ */
+static inline void event_post(uint8_t event)
+{
+    pending_events |= event;
+}
+
+uint8_t events_wait(void);
+
+#endif // EVENTS_H
@@ -0,0 +1,53 @@
+/* 
+ * File: font.c
+ * Custom characters for text, see font.h.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "font.h"
+#include "lcd.h"
+
+#if !LCD_GLYPH_CACHE
+#error "font.c needs LCD_GLYPH_CACHE set in lcd.h"
+#endif
+
+typedef struct
+{
+    char code;          // ISO-8859-1 code or icon code from font.h
+    uint8_t rows[8];    // Dots in bits 4-0, top row first
+} font_char_t;
+
+static const font_char_t font[] PROGMEM =
+{
+    {'\xE5', {0x04, 0x0A, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F}},    // å
+    {'\xE4', {0x0A, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00}},    // ä
+    {'\xF6', {0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},    // ö
+    {'\xC5', {0x04, 0x0A, 0x04, 0x0E, 0x11, 0x1F, 0x11, 0x00}},    // Å
+    {'\xC4', {0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00}},    // Ä
+    {'\xD6', {0x0A, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}},    // Ö
+    {'\x80', {0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00}},    // Bell
+    {'\x81', {0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00, 0x00}},    // Heart
+};
+
+void font_fb_puts(const char *s)
+{
+    char c;
+    
+    while ((c = *s++))
+    {
+        // Plain ASCII is in the character ROM
+        if ((uint8_t)c >= 0x80)
+        {
+            for (uint8_t i = 0; i < sizeof(font) / sizeof(font[0]); i++)
+            {
+                if ((char)pgm_read_byte(&font[i].code) == c)
+                {
+                    c = lcd_glyph(font[i].rows);
+                    break;
+                }
+            }
+        }
+        lcd_fb_putc(c);
+    }
+}
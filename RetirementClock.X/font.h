@@ -0,0 +1,21 @@
+/* 
+ * File: font.h
+ * Finnish letters and icons as LCD custom characters.
+ * 
+ * The character ROM has no å, and its ä and ö don't match the other
+ * letters. font_fb_puts() draws text with these letters written in
+ * ISO-8859-1 and shows them through the glyph cache of lcd.c, so a text
+ * can use any of them as long as a frame has at most 8 custom characters.
+ */
+
+#ifndef FONT_H
+#define FONT_H
+
+// Icons, codes that ISO-8859-1 text doesn't use. For string literals
+#define FONT_BELL   "\x80"
+#define FONT_HEART  "\x81"
+
+// Draw text into the framebuffer, custom characters through lcd_glyph()
+void font_fb_puts(const char *s);
+
+#endif // FONT_H
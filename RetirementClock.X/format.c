@@ -0,0 +1,76 @@
+/* 
+ * File: format.c
+ * Small fixed cost number formatting used instead of sprintf.
+ * AVR has no hardware divider, so digits are found by repeated subtraction
+ * of powers of ten. That takes at most 9 subtractions per digit.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "format.h"
+
+// Powers of ten for fmt_u32(), largest first
+static const uint32_t powers_of_ten[] PROGMEM =
+{
+    1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10
+};
+
+char *fmt_u8_2(char *dst, uint8_t value)
+{
+    char tens = '0';
+    
+    while (value >= 10)
+    {
+        value -= 10;
+        tens++;
+    }
+    *dst++ = tens;
+    *dst++ = '0' + value;
+    return dst;
+}
+
+char *fmt_u16_4(char *dst, uint16_t value)
+{
+    char digit = '0';
+    
+    while (value >= 1000)
+    {
+        value -= 1000;
+        digit++;
+    }
+    *dst++ = digit;
+    digit = '0';
+    while (value >= 100)
+    {
+        value -= 100;
+        digit++;
+    }
+    *dst++ = digit;
+    return fmt_u8_2(dst, value);
+}
+
+char *fmt_u32(char *dst, uint32_t value)
+{
+    uint8_t started = 0;
+    
+    for (uint8_t i = 0; i < sizeof(powers_of_ten) / sizeof(powers_of_ten[0]); i++)
+    {
+        uint32_t power = pgm_read_dword(&powers_of_ten[i]);
+        char digit = '0';
+        
+        while (value >= power)
+        {
+            value -= power;
+            digit++;
+        }
+        // Skip leading zeros
+        if (started || (digit != '0'))
+        {
+            *dst++ = digit;
+            started = 1;
+        }
+    }
+    // Last digit is written even when the value is 0
+    *dst++ = '0' + value;
+    return dst;
+}
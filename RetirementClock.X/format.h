@@ -0,0 +1,21 @@
+/* 
+ * File: format.h
+ * Small fixed cost number formatting used instead of sprintf.
+ * 
+ * The functions write digits to dst without a terminating '\0' and return a
+ * pointer just past the last digit, so calls can be chained to build a line.
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdint.h>
+
+// Two digits with a leading zero, value must be below 100
+char *fmt_u8_2(char *dst, uint8_t value);
+// Four digits with leading zeros, value must be below 10000
+char *fmt_u16_4(char *dst, uint16_t value);
+// Unsigned decimal without leading zeros (1 to 10 digits)
+char *fmt_u32(char *dst, uint32_t value);
+
+#endif // FORMAT_H
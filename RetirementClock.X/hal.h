@@ -0,0 +1,30 @@
+/* 
+ * File: hal.h
+ * Board outputs used by the portable code in app.c and lcd.c.
+ * 
+ * hal_avr.c drives the pins on the board. The host simulator implements
+ * the same functions in host/hal_host.c and records what they do instead.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// Set the backlight and buzzer pins up as outputs, both off
+void hal_init(void);
+void hal_buzzer(uint8_t on);
+void hal_backlight(uint8_t on);
+void hal_backlight_toggle(void);
+
+/*
+ * LCD bus, only used by lcd.c when built with LCD_HAL_BUS set. A nibble is
+ * put on D4-D7 with the given RS and latched with an E pulse, or read back
+ * with RW high while E is high. On the board lcd.c drives the pins itself.
+ */
+void hal_lcd_bus_init(void);
+void hal_lcd_nibble_out(uint8_t nibble, uint8_t rs);
+uint8_t hal_lcd_nibble_in(uint8_t rs);
+void hal_delay_us(uint16_t us);
+
+#endif // HAL_H
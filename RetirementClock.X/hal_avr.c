@@ -0,0 +1,44 @@
+/* 
+ * File: hal_avr.c
+ * Board outputs for hal.h: LCD backlight on PB5, active buzzer on PA7.
+ */
+
+#include <avr/io.h>
+#include "hal.h"
+
+void hal_init(void)
+{
+    // Set LCD backlight as output
+    PORTB.DIRSET = PIN5_bm;   
+    // Set buzzer as output
+    PORTA.DIRSET = PIN7_bm;
+}
+
+void hal_buzzer(uint8_t on)
+{
+    if (on)
+    {
+        PORTA.OUTSET = PIN7_bm;
+    }
+    else
+    {
+        PORTA.OUTCLR = PIN7_bm;
+    }
+}
+
+void hal_backlight(uint8_t on)
+{
+    if (on)
+    {
+        PORTB.OUTSET = PIN5_bm;
+    }
+    else
+    {
+        PORTB.OUTCLR = PIN5_bm;
+    }
+}
+
+void hal_backlight_toggle(void)
+{
+    PORTB.OUTTGL = PIN5_bm;
+}
@@ -0,0 +1,326 @@
+/* 
+ * File: bench.c
+ * Benchmarks of the RetirementClock hot paths on the host.
+ * 
+ * LCD costs come from the HD44780 model and are deterministic: bus
+ * nibbles, instructions and the simulated bus time, busy time included.
+ * They don't depend on the machine, so any change between commits is a
+ * real change in what the firmware sends. Commands also report the bytes
+ * they read from program memory, counted by the pgmspace shim, and the
+ * button reports the PIT wakeups and events of a press, both as
+ * deterministic. host_time metrics are host wall time, only comparable
+ * on the same machine.
+ * 
+ * Output is CSV on stdout, one metric per line:
+ *   benchmark,metric,value,unit
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "app.h"
+#include "hal.h"
+#include "lcd.h"
+#include "serial.h"
+#include "clock.h"
+#include "format.h"
+#include "button.h"
+#include "events.h"
+#include "hal_host.h"
+
+// Renders measured per view, one per simulated second
+#define TICKS 600
+// Calls per wall time measurement
+#define CALLS 20000
+
+// Commands measured, with arguments that pass validation
+static const char *const commands[] =
+{
+    "GET DATETIME",
+    "SET DATETIME 31 12 2020 23 59 55",
+    "GET BIRTHDAY",
+    "SET BIRTHDAY 31 12 1965",
+    "GET RXSTATS",
+    "GET RUNTIME",
+    "TGL BACKLIGHT",
+    "SET DATETIME 31 2 2021 0 0 0",
+    "NO SUCH COMMAND",
+};
+
+// Button presses measured: PIT ticks held down, after a bounce of
+// bounce ticks that read alternately released and pressed
+typedef struct
+{
+    const char *name;
+    uint8_t bounce;
+    uint16_t held;
+} press_t;
+
+static const press_t presses[] =
+{
+    {"click", 0, 20},
+    {"click_bounce", 4, 20},
+    {"long", 0, BUTTON_LONG_TICKS + 10},
+    {"repeat", 0, BUTTON_LONG_TICKS + 4 * BUTTON_REPEAT_TICKS},
+    {"glitch", 1, 0},
+};
+
+// button.c posts here, there is no superloop to drain the events
+volatile uint8_t pending_events = 0;
+
+void PORTF_PORT_vect(void);
+void RTC_PIT_vect(void);
+
+static const char *const views[LCD_MODES] = {"clock", "countdown", "runtime",
+        "bigclock"};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void print_metric(const char *bench, const char *metric, double value,
+        const char *unit)
+{
+    printf("%s,%s,%.3f,%s\n", bench, metric, value, unit);
+}
+
+// Print the LCD bus activity since the last reset, divided by count
+static void print_lcd_cost(const char *bench, uint32_t count)
+{
+    hd44780_t *lcd = host_lcd();
+    const hd44780_stats_t *st = &lcd->stats;
+    
+    print_metric(bench, "nibbles", (double)st->nibbles / count, "");
+    print_metric(bench, "instructions", (double)st->instructions / count, "");
+    print_metric(bench, "data_writes", (double)st->data_writes / count, "");
+    print_metric(bench, "status_reads", (double)st->status_reads / count, "");
+    print_metric(bench, "busy_time", st->busy_ns / 1000.0 / count, "us");
+    print_metric(bench, "bus_time", st->elapsed_ns / 1000.0 / count, "us");
+    print_metric(bench, "violations", st->violations, "");
+    hd44780_stats_reset(lcd);
+}
+
+// LCD cost of redrawing each view once a second
+static void bench_ticks(void)
+{
+    char name[32];
+    
+    for (uint8_t view = 0; view < LCD_MODES; view++)
+    {
+        app_init();
+        render();
+        hd44780_stats_reset(host_lcd());
+        for (uint16_t i = 0; i < TICKS; i++)
+        {
+            app_advance(1);
+            render();
+        }
+        snprintf(name, sizeof(name), "lcd_tick_%s", views[view]);
+        print_lcd_cost(name, TICKS);
+        // Ends back at the clock view
+        app_next_view();
+    }
+}
+
+// LCD cost of writing characters and of repainting the whole display
+static void bench_lcd(void)
+{
+    lcd_gotoxy(0, 0);
+    hd44780_stats_reset(host_lcd());
+    for (uint8_t i = 0; i < LCD_DISP_LENGTH; i++)
+    {
+        lcd_putc('0' + i % 10);
+    }
+    print_lcd_cost("lcd_putc", LCD_DISP_LENGTH);
+    
+    lcd_fb_invalidate();
+    lcd_flush();
+    hd44780_stats_reset(host_lcd());
+    lcd_fb_invalidate();
+    lcd_flush();
+    print_lcd_cost("lcd_flush_full", 1);
+}
+
+// Host time, program memory reads and console output of every command
+static void bench_commands(void)
+{
+    char name[48];
+    
+    for (uint8_t c = 0; c < sizeof(commands) / sizeof(commands[0]); c++)
+    {
+        size_t out_len;
+        uint32_t flash_reads;
+        double start;
+        
+        host_flash_reads = 0;
+        execute_command(commands[c]);
+        flash_reads = host_flash_reads;
+        out_len = strlen(host_uart_take());
+        
+        start = now_ns();
+        for (uint32_t i = 0; i < CALLS; i++)
+        {
+            execute_command(commands[c]);
+            host_uart_take();
+        }
+        
+        snprintf(name, sizeof(name), "command_%s", commands[c]);
+        for (char *p = name; *p; p++)
+        {
+            if (*p == ' ')
+            {
+                *p = '_';
+            }
+        }
+        print_metric(name, "host_time", (now_ns() - start) / CALLS, "ns");
+        print_metric(name, "flash_reads", flash_reads, "bytes");
+        print_metric(name, "output", out_len, "bytes");
+    }
+    app_init();
+}
+
+// Host time of the clock arithmetic behind every wakeup
+static void bench_clock(void)
+{
+    static const uint32_t steps[] = {1, 60, 86400};
+    char name[32];
+    volatile uint32_t sink = 0;
+    char buffer[11];
+    double start;
+    
+    for (uint8_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++)
+    {
+        app_init();
+        start = now_ns();
+        for (uint32_t i = 0; i < CALLS; i++)
+        {
+            clock_advance(steps[s]);
+        }
+        snprintf(name, sizeof(name), "clock_advance_%lu", 
+                (unsigned long)steps[s]);
+        print_metric(name, "host_time", (now_ns() - start) / CALLS, "ns");
+    }
+    app_init();
+    
+    start = now_ns();
+    for (uint32_t i = 0; i < CALLS; i++)
+    {
+        sink += fmt_u32(buffer, i * 2654435761UL) - buffer;
+    }
+    print_metric("fmt_u32", "host_time", (now_ns() - start) / CALLS, "ns");
+}
+
+/*
+ * One PIT period of the button pin at the given level. A falling edge
+ * raises the pin interrupt while it is armed, the PIT interrupt runs while
+ * button.c has the PIT enabled. Returns the number of PIT wakeups.
+ */
+static uint8_t button_step(uint8_t pressed)
+{
+    uint8_t was_high = VPORTF.IN & PIN6_bm;
+    
+    VPORTF.IN = pressed ? 0 : PIN6_bm;
+    if (was_high && pressed
+            && ((PORTF.PIN6CTRL & PORT_ISC_gm) == PORT_ISC_FALLING_gc))
+    {
+        PORTF_PORT_vect();
+    }
+    if (RTC.PITCTRLA & RTC_PITEN_bm)
+    {
+        RTC_PIT_vect();
+        return 1;
+    }
+    return 0;
+}
+
+// Count and clear the events button.c has posted
+static uint8_t take_events(void)
+{
+    uint8_t count = 0;
+    
+    for (uint8_t e = pending_events; e; e &= e - 1)
+    {
+        count++;
+    }
+    pending_events = 0;
+    return count;
+}
+
+// PIT wakeups and events of each press, and host time of a PIT sample
+static void bench_button(void)
+{
+    char name[32];
+    double start;
+    
+    button_init();
+    for (uint8_t p = 0; p < sizeof(presses) / sizeof(presses[0]); p++)
+    {
+        const press_t *press = &presses[p];
+        uint32_t wakeups = 0;
+        uint32_t events = 0;
+        
+        for (uint8_t i = 0; i < press->bounce; i++)
+        {
+            wakeups += button_step(!(i & 1));
+        }
+        for (uint16_t i = 0; i < press->held; i++)
+        {
+            wakeups += button_step(1);
+            events += take_events();
+        }
+        // Released until the PIT stops, a few ticks of debounce
+        while (RTC.PITCTRLA & RTC_PITEN_bm)
+        {
+            wakeups += button_step(0);
+        }
+        events += take_events();
+        
+        snprintf(name, sizeof(name), "button_%s", press->name);
+        print_metric(name, "pit_wakeups", wakeups, "");
+        print_metric(name, "events", events, "");
+    }
+    
+    // Sample cost while held down after a long press, the busiest path
+    for (uint16_t i = 0; i <= BUTTON_LONG_TICKS; i++)
+    {
+        button_step(1);
+    }
+    start = now_ns();
+    for (uint32_t i = 0; i < CALLS; i++)
+    {
+        RTC_PIT_vect();
+    }
+    print_metric("button_pit_sample", "host_time", (now_ns() - start) / CALLS,
+            "ns");
+    while (RTC.PITCTRLA & RTC_PITEN_bm)
+    {
+        button_step(0);
+    }
+    pending_events = 0;
+}
+
+int main(void)
+{
+    hal_init();
+    lcd_init(LCD_DISP_ON);
+    USART0_init();
+    app_init();
+    
+    printf("benchmark,metric,value,unit\n");
+    print_lcd_cost("lcd_init", 1);
+    bench_ticks();
+    bench_lcd();
+    bench_commands();
+    bench_clock();
+    bench_button();
+    return 0;
+}
@@ -0,0 +1,188 @@
+/* 
+ * File: hal_host.c
+ * hal.h and serial.h for the host simulator, see hal_host.h.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "hal.h"
+#include "serial.h"
+#include "hal_host.h"
+
+// Bus time of one nibble: pins set up, E high for LCD_DELAY_ENABLE_PULSE
+// and low again, at the 3.33 MHz CPU clock
+#define LCD_NIBBLE_NS 2000
+
+#define RX_BUFFER_SIZE 256
+#define TX_BUFFER_SIZE 4096
+
+// Registers of the shim, the button pin idles high
+PORT_t PORTF;
+VPORT_t VPORTF = {PIN6_bm};
+RTC_t RTC;
+uint32_t host_flash_reads;
+
+static hd44780_t lcd;
+static uint8_t buzzer;
+static uint8_t backlight;
+
+// Received bytes waiting for USART0_read()
+static char rx_buffer[RX_BUFFER_SIZE];
+static uint16_t rx_head;
+static uint16_t rx_tail;
+static uint16_t rx_dropped;
+
+// Transmitted bytes waiting for host_uart_take()
+static char tx_buffer[TX_BUFFER_SIZE + 1];
+static uint16_t tx_len;
+
+void hal_init(void)
+{
+    buzzer = 0;
+    backlight = 0;
+}
+
+void hal_buzzer(uint8_t on)
+{
+    buzzer = on;
+}
+
+void hal_backlight(uint8_t on)
+{
+    backlight = on;
+}
+
+void hal_backlight_toggle(void)
+{
+    backlight = !backlight;
+}
+
+void hal_lcd_bus_init(void)
+{
+    hd44780_reset(&lcd);
+}
+
+void hal_lcd_nibble_out(uint8_t nibble, uint8_t rs)
+{
+    hd44780_advance(&lcd, LCD_NIBBLE_NS);
+    hd44780_write(&lcd, nibble, rs);
+}
+
+uint8_t hal_lcd_nibble_in(uint8_t rs)
+{
+    hd44780_advance(&lcd, LCD_NIBBLE_NS);
+    return hd44780_read(&lcd, rs);
+}
+
+void hal_delay_us(uint16_t us)
+{
+    hd44780_advance(&lcd, us * 1000UL);
+}
+
+void USART0_init(void)
+{
+    rx_head = rx_tail = 0;
+    rx_dropped = 0;
+    tx_len = 0;
+}
+
+uint8_t USART0_write(const char *data, uint8_t len)
+{
+    uint8_t queued = 0;
+    
+    while ((queued < len) && (tx_len < TX_BUFFER_SIZE))
+    {
+        tx_buffer[tx_len++] = data[queued++];
+    }
+    return queued;
+}
+
+void USART0_sendChar(char c)
+{
+    USART0_write(&c, 1);
+}
+
+void USART0_sendString(const char *str)
+{
+    while (*str)
+    {
+        USART0_sendChar(*str++);
+    }
+}
+
+void USART0_flush(void)
+{
+}
+
+uint8_t USART0_txBusy(void)
+{
+    return 0;
+}
+
+uint8_t USART0_read(char *c)
+{
+    if (rx_head == rx_tail)
+    {
+        return 0;
+    }
+    *c = rx_buffer[rx_tail];
+    rx_tail = (rx_tail + 1) % RX_BUFFER_SIZE;
+    return 1;
+}
+
+char USART0_readChar(void)
+{
+    char c = '\0';
+    
+    // Nothing else can fill the buffer, so don't wait for it
+    USART0_read(&c);
+    return c;
+}
+
+uint16_t USART0_rxDropped(void)
+{
+    return rx_dropped;
+}
+
+void host_uart_receive(const char *s)
+{
+    while (*s)
+    {
+        uint16_t next = (rx_head + 1) % RX_BUFFER_SIZE;
+        
+        if (next == rx_tail)
+        {
+            rx_dropped++;
+        }
+        else
+        {
+            rx_buffer[rx_head] = *s;
+            rx_head = next;
+        }
+        s++;
+    }
+}
+
+const char *host_uart_take(void)
+{
+    tx_buffer[tx_len] = '\0';
+    tx_len = 0;
+    return tx_buffer;
+}
+
+hd44780_t *host_lcd(void)
+{
+    return &lcd;
+}
+
+uint8_t host_buzzer(void)
+{
+    return buzzer;
+}
+
+uint8_t host_backlight(void)
+{
+    return backlight;
+}
@@ -0,0 +1,26 @@
+/* 
+ * File: hal_host.h
+ * Host side of hal.h and serial.h for the simulator: outputs are recorded,
+ * the console is a pair of byte buffers and the LCD bus goes to a modelled
+ * HD44780.
+ */
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdint.h>
+#include "hd44780.h"
+
+// Queue bytes as if USART0 had received them
+void host_uart_receive(const char *s);
+/*
+ * Everything USART0 has transmitted since the last call, '\0' terminated.
+ * Taking it empties the buffer, the text is valid until USART0 sends more.
+ */
+const char *host_uart_take(void);
+// The modelled display controller
+hd44780_t *host_lcd(void);
+uint8_t host_buzzer(void);
+uint8_t host_backlight(void);
+
+#endif // HAL_HOST_H
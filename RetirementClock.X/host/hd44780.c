@@ -0,0 +1,244 @@
+/* 
+ * File: hd44780.c
+ * Model of an HD44780 character LCD controller, see hd44780.h.
+ */
+
+#include <string.h>
+#include "hd44780.h"
+
+// Instruction bits, see the HD44780U data sheet
+#define CMD_CLEAR       0x01
+#define CMD_HOME        0x02
+#define CMD_ENTRY       0x04
+#define CMD_DISPLAY     0x08
+#define CMD_SHIFT       0x10
+#define CMD_FUNCTION    0x20
+#define CMD_CGRAM       0x40
+#define CMD_DDRAM       0x80
+
+#define ENTRY_INC       0x02
+#define SHIFT_DISPLAY   0x08
+#define SHIFT_RIGHT     0x04
+#define FUNCTION_8BIT   0x10
+#define FUNCTION_2LINES 0x08
+
+#define BUSY_FLAG       0x80
+
+void hd44780_reset(hd44780_t *lcd)
+{
+    memset(lcd, 0, sizeof(*lcd));
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+    lcd->entry = CMD_ENTRY | ENTRY_INC;
+    lcd->function = CMD_FUNCTION | FUNCTION_8BIT;
+}
+
+void hd44780_advance(hd44780_t *lcd, uint32_t ns)
+{
+    lcd->now_ns += ns;
+    lcd->stats.elapsed_ns += ns;
+}
+
+uint8_t hd44780_busy(const hd44780_t *lcd)
+{
+    return lcd->now_ns < lcd->busy_until_ns;
+}
+
+void hd44780_stats_reset(hd44780_t *lcd)
+{
+    memset(&lcd->stats, 0, sizeof(lcd->stats));
+}
+
+// Start an operation that keeps the controller busy for ns
+static void start_busy(hd44780_t *lcd, uint32_t ns)
+{
+    lcd->busy_until_ns = lcd->now_ns + ns;
+    lcd->stats.busy_ns += ns;
+}
+
+// Move the address counter one step, wrapping like the real DDRAM layout
+static void step_ac(hd44780_t *lcd, uint8_t inc)
+{
+    if (lcd->cgram_mode)
+    {
+        lcd->ac = (lcd->ac + (inc ? 1 : -1)) & (HD44780_CGRAM_SIZE - 1);
+    }
+    else if (lcd->function & FUNCTION_2LINES)
+    {
+        // Two lines of 40 characters at 0x00-0x27 and 0x40-0x67
+        if (inc)
+        {
+            lcd->ac = (lcd->ac == 0x27) ? 0x40 : (lcd->ac == 0x67) ? 0x00 
+                    : lcd->ac + 1;
+        }
+        else
+        {
+            lcd->ac = (lcd->ac == 0x40) ? 0x27 : (lcd->ac == 0x00) ? 0x67 
+                    : lcd->ac - 1;
+        }
+    }
+    else
+    {
+        // One line of 80 characters
+        if (inc)
+        {
+            lcd->ac = (lcd->ac >= 0x4F) ? 0x00 : lcd->ac + 1;
+        }
+        else
+        {
+            lcd->ac = (lcd->ac == 0x00) ? 0x4F : lcd->ac - 1;
+        }
+    }
+}
+
+static void execute(hd44780_t *lcd, uint8_t cmd)
+{
+    lcd->stats.instructions++;
+    start_busy(lcd, (cmd == CMD_CLEAR) || ((cmd & ~0x01) == CMD_HOME) 
+            ? HD44780_CLEAR_NS : HD44780_EXEC_NS);
+    
+    if (cmd & CMD_DDRAM)
+    {
+        lcd->ac = cmd & 0x7F;
+        lcd->cgram_mode = 0;
+    }
+    else if (cmd & CMD_CGRAM)
+    {
+        lcd->ac = cmd & 0x3F;
+        lcd->cgram_mode = 1;
+    }
+    else if (cmd & CMD_FUNCTION)
+    {
+        lcd->function = cmd;
+        lcd->four_bit = !(cmd & FUNCTION_8BIT);
+    }
+    else if (cmd & CMD_SHIFT)
+    {
+        // Display shifts aren't modelled, the shown window stays at 0
+        if (!(cmd & SHIFT_DISPLAY))
+        {
+            step_ac(lcd, cmd & SHIFT_RIGHT);
+        }
+    }
+    else if (cmd & CMD_DISPLAY)
+    {
+        lcd->display = cmd;
+    }
+    else if (cmd & CMD_ENTRY)
+    {
+        lcd->entry = cmd;
+    }
+    else if (cmd & CMD_HOME)
+    {
+        lcd->ac = 0;
+        lcd->cgram_mode = 0;
+    }
+    else if (cmd & CMD_CLEAR)
+    {
+        memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+        lcd->ac = 0;
+        lcd->cgram_mode = 0;
+        lcd->entry |= ENTRY_INC;
+    }
+}
+
+static void write_data(hd44780_t *lcd, uint8_t data)
+{
+    lcd->stats.data_writes++;
+    start_busy(lcd, HD44780_EXEC_NS);
+    
+    if (lcd->cgram_mode)
+    {
+        lcd->cgram[lcd->ac] = data;
+    }
+    else
+    {
+        lcd->ddram[lcd->ac] = data;
+    }
+    step_ac(lcd, lcd->entry & ENTRY_INC);
+}
+
+static uint8_t read_data(hd44780_t *lcd)
+{
+    uint8_t data = lcd->cgram_mode ? lcd->cgram[lcd->ac] : lcd->ddram[lcd->ac];
+    
+    lcd->stats.data_reads++;
+    start_busy(lcd, HD44780_EXEC_NS);
+    step_ac(lcd, lcd->entry & ENTRY_INC);
+    return data;
+}
+
+void hd44780_write(hd44780_t *lcd, uint8_t nibble, uint8_t rs)
+{
+    uint8_t byte;
+    
+    nibble &= 0x0F;
+    lcd->stats.nibbles++;
+    if (!lcd->four_bit)
+    {
+        // Only D4-D7 are connected, D0-D3 read as 0
+        byte = nibble << 4;
+    }
+    else if (!lcd->low_next)
+    {
+        lcd->latch = nibble << 4;
+        lcd->low_next = 1;
+        return;
+    }
+    else
+    {
+        byte = lcd->latch | nibble;
+        lcd->low_next = 0;
+    }
+    
+    // The controller ignores the bus until it's done
+    if (hd44780_busy(lcd))
+    {
+        lcd->stats.violations++;
+    }
+    else if (rs)
+    {
+        write_data(lcd, byte);
+    }
+    else
+    {
+        execute(lcd, byte);
+    }
+}
+
+uint8_t hd44780_read(hd44780_t *lcd, uint8_t rs)
+{
+    lcd->stats.nibbles++;
+    if (lcd->four_bit && lcd->low_next)
+    {
+        lcd->low_next = 0;
+        return lcd->latch & 0x0F;
+    }
+    
+    if (!rs)
+    {
+        lcd->stats.status_reads++;
+        lcd->latch = lcd->ac & ~BUSY_FLAG;
+        if (hd44780_busy(lcd))
+        {
+            lcd->stats.busy_polls++;
+            lcd->latch |= BUSY_FLAG;
+        }
+    }
+    else if (hd44780_busy(lcd))
+    {
+        // Data read while busy returns garbage and doesn't move the AC
+        lcd->stats.violations++;
+        lcd->latch = 0xFF;
+    }
+    else
+    {
+        lcd->latch = read_data(lcd);
+    }
+    lcd->low_next = lcd->four_bit;
+    return lcd->latch >> 4;
+}
+
+void hd44780_row(const hd44780_t *lcd, uint8_t row, char *dst, uint8_t len)
+{
+    memcpy(dst, &lcd->ddram[row ? 0x40 : 0x00], len);
+}
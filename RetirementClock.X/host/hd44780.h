@@ -0,0 +1,78 @@
+/* 
+ * File: hd44780.h
+ * Model of an HD44780 character LCD controller on a 4-bit bus, for the
+ * host simulator.
+ * 
+ * The controller starts in 8-bit mode, where each nibble written is a
+ * whole instruction with the low data lines reading 0, until a function
+ * set switches it to 4-bit mode. After that nibbles pair up high first.
+ * 
+ * Time only moves when hd44780_advance() is called, the HAL does that for
+ * delays and bus cycles. Every instruction and data access keeps the
+ * controller busy for its execution time from the data sheet (fosc
+ * 270 kHz). The busy flag reads 1 until then and anything written in the
+ * meantime is lost, as on the real controller, and counted as a violation.
+ */
+
+#ifndef HD44780_H
+#define HD44780_H
+
+#include <stdint.h>
+
+#define HD44780_DDRAM_SIZE  0x80
+#define HD44780_CGRAM_SIZE  0x40
+
+// Execution times in nanoseconds
+#define HD44780_CLEAR_NS    1520000UL  // Clear display, return home
+#define HD44780_EXEC_NS     37000UL    // Other instructions, data access
+
+// Bus and controller activity since the last hd44780_stats_reset()
+typedef struct
+{
+    uint32_t nibbles;       // E strobes, reads and writes
+    uint32_t instructions;  // Instructions written
+    uint32_t data_writes;   // Bytes written to DDRAM/CGRAM
+    uint32_t data_reads;    // Bytes read from DDRAM/CGRAM
+    uint32_t status_reads;  // Busy flag/address counter reads
+    uint32_t busy_polls;    // Status reads that found the busy flag set
+    uint32_t violations;    // Bytes lost because they came while busy
+    uint64_t busy_ns;       // Time the controller spent executing
+    uint64_t elapsed_ns;    // Time passed in total
+} hd44780_stats_t;
+
+typedef struct
+{
+    uint8_t ddram[HD44780_DDRAM_SIZE];
+    uint8_t cgram[HD44780_CGRAM_SIZE];
+    uint8_t ac;             // Address counter
+    uint8_t cgram_mode;     // 1: the address counter points into CGRAM
+    uint8_t entry;          // Last entry mode set
+    uint8_t display;        // Last display on/off control
+    uint8_t function;       // Last function set
+    uint8_t four_bit;       // 1: bus is in 4-bit mode
+    uint8_t low_next;       // 1: next nibble is the low half of a byte
+    uint8_t latch;          // Byte being transferred a nibble at a time
+    uint64_t now_ns;        // Simulated time
+    uint64_t busy_until_ns; // End of the operation in progress
+    hd44780_stats_t stats;
+} hd44780_t;
+
+// Power-on state: 8-bit mode, DDRAM cleared, display off, time 0
+void hd44780_reset(hd44780_t *lcd);
+// Let time pass
+void hd44780_advance(hd44780_t *lcd, uint32_t ns);
+// Nonzero while an instruction or data access is executing
+uint8_t hd44780_busy(const hd44780_t *lcd);
+// Nibble latched on the falling edge of E with RW low
+void hd44780_write(hd44780_t *lcd, uint8_t nibble, uint8_t rs);
+// Nibble driven while E is high with RW high
+uint8_t hd44780_read(hd44780_t *lcd, uint8_t rs);
+/*
+ * Copy the len characters shown on row 0 or 1 to dst, no terminator.
+ * Characters are the raw DDRAM codes, 0-15 are CGRAM glyphs.
+ */
+void hd44780_row(const hd44780_t *lcd, uint8_t row, char *dst, uint8_t len);
+// Clear the activity counters, the display contents are kept
+void hd44780_stats_reset(hd44780_t *lcd);
+
+#endif // HD44780_H
@@ -0,0 +1,15 @@
+/* 
+ * File: shim/avr/interrupt.h
+ * Host stand-in for <avr/interrupt.h>. The simulator has no interrupts,
+ * an ISR is an ordinary function named after its vector that the host
+ * code calls where the hardware would raise it.
+ */
+
+#ifndef SHIM_AVR_INTERRUPT_H
+#define SHIM_AVR_INTERRUPT_H
+
+#define sei()
+#define cli()
+#define ISR(vector) void vector(void); void vector(void)
+
+#endif // SHIM_AVR_INTERRUPT_H
@@ -0,0 +1,46 @@
+/* 
+ * File: shim/avr/io.h
+ * Host stand-in for <avr/io.h>. The portable code doesn't touch registers.
+ * button.c does, so the PORTF and RTC PIT registers it uses are plain
+ * variables here, defined in hal_host.c, for bench.c to drive it with.
+ */
+
+#ifndef SHIM_AVR_IO_H
+#define SHIM_AVR_IO_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t DIRCLR;
+    uint8_t INTFLAGS;
+    uint8_t PIN6CTRL;
+} PORT_t;
+
+typedef struct
+{
+    uint8_t IN;
+} VPORT_t;
+
+typedef struct
+{
+    uint8_t PITCTRLA;
+    uint8_t PITSTATUS;
+    uint8_t PITINTCTRL;
+    uint8_t PITINTFLAGS;
+} RTC_t;
+
+extern PORT_t PORTF;
+extern VPORT_t VPORTF;
+extern RTC_t RTC;
+
+#define PIN6_bm                 0x40
+#define PORT_ISC_gm             0x07
+#define PORT_ISC_INTDISABLE_gc  0x00
+#define PORT_ISC_FALLING_gc     0x03
+#define RTC_CTRLBUSY_bm         0x01
+#define RTC_PI_bm               0x01
+#define RTC_PITEN_bm            0x01
+#define RTC_PERIOD_CYC256_gc    (0x07 << 3)
+
+#endif // SHIM_AVR_IO_H
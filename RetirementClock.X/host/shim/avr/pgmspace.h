@@ -0,0 +1,37 @@
+/* 
+ * File: shim/avr/pgmspace.h
+ * Host stand-in for <avr/pgmspace.h>. Program memory is ordinary memory.
+ * Every byte read from it is counted in host_flash_reads, which gives the
+ * benchmark a cost that doesn't depend on the host machine.
+ */
+
+#ifndef SHIM_AVR_PGMSPACE_H
+#define SHIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Bytes read from program memory, defined in hal_host.c
+extern uint32_t host_flash_reads;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p)    (host_flash_reads += 1, *(const uint8_t *)(p))
+#define pgm_read_word(p)    (host_flash_reads += 2, *(const uint16_t *)(p))
+#define pgm_read_dword(p)   (host_flash_reads += 4, *(const uint32_t *)(p))
+
+static inline void *memcpy_P(void *dest, const void *src, size_t n)
+{
+    host_flash_reads += n;
+    return memcpy(dest, src, n);
+}
+
+static inline size_t strlen_P(const char *s)
+{
+    size_t len = strlen(s);
+    
+    host_flash_reads += len + 1;
+    return len;
+}
+
+#endif // SHIM_AVR_PGMSPACE_H
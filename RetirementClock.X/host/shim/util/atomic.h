@@ -0,0 +1,14 @@
+/* 
+ * File: shim/util/atomic.h
+ * Host stand-in for <util/atomic.h>. Nothing can interrupt the simulator,
+ * so an atomic block just runs once.
+ */
+
+#ifndef SHIM_UTIL_ATOMIC_H
+#define SHIM_UTIL_ATOMIC_H
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON      0
+#define ATOMIC_BLOCK(type)  for (int atomic_once_ = 1; atomic_once_; atomic_once_ = 0)
+
+#endif // SHIM_UTIL_ATOMIC_H
@@ -0,0 +1,16 @@
+/* 
+ * File: shim/util/delay.h
+ * Host stand-in for <util/delay.h>. Delays advance the simulated time
+ * kept by hal_host.c instead of spinning.
+ */
+
+#ifndef SHIM_UTIL_DELAY_H
+#define SHIM_UTIL_DELAY_H
+
+#include "hal.h"
+
+#define _delay_us(us)   hal_delay_us(us)
+#define _delay_ms(ms)   do { for (uint16_t delay_ms_ = 0; delay_ms_ < (ms); \
+                            delay_ms_++) hal_delay_us(1000); } while (0)
+
+#endif // SHIM_UTIL_DELAY_H
@@ -0,0 +1,15 @@
+/* 
+ * File: shim/util/delay_basic.h
+ * Host stand-in for <util/delay_basic.h>. A loop of _delay_loop_2() takes
+ * four CPU cycles at F_CPU, which the including file defines.
+ */
+
+#ifndef SHIM_UTIL_DELAY_BASIC_H
+#define SHIM_UTIL_DELAY_BASIC_H
+
+#include "hal.h"
+
+#define _delay_loop_2(count)    hal_delay_us((uint16_t)(((uint32_t)(count) \
+                                    * 4000000UL + F_CPU - 1) / F_CPU))
+
+#endif // SHIM_UTIL_DELAY_BASIC_H
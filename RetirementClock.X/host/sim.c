@@ -0,0 +1,234 @@
+/* 
+ * File: sim.c
+ * RetirementClock on the host. Runs the superloop of main.c against a
+ * simulated RTC counter, with the console and LCD from hal_host.c.
+ * 
+ * Reads a script from stdin, one action per line:
+ *   wait N       let N seconds pass, waking up like the firmware does
+ *   click        short button press, next view
+ *   long         long button press, toggles the backlight
+ *   send TEXT    type TEXT and enter in the console
+ *   show         print the LCD, backlight and buzzer
+ *   expect R TEXT  stop with an error unless LCD row R shows TEXT, trailing
+ *                spaces ignored, '#' as in show
+ *   stats        print the LCD bus activity since the last stats, see
+ *                hd44780_stats_t
+ *   # ...        comment
+ * Console output is printed as "uart: " lines, the LCD as "lcd: |...|".
+ * The exit status is 1 if an expect failed or an action was unknown.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app.h"
+#include "hal.h"
+#include "lcd.h"
+#include "serial.h"
+#include "hal_host.h"
+
+#define SCRIPT_LINE_LEN 128
+
+// Simulated RTC counter, compare register and last synced count
+static uint16_t rtc_count;
+static uint16_t rtc_compare;
+static uint16_t rtc_synced;
+
+// Same as rtc_sync() in main.c
+static void rtc_sync(void)
+{
+    uint16_t elapsed = rtc_count - rtc_synced;
+    
+    rtc_synced += elapsed;
+    app_advance(elapsed);
+}
+
+// Same as rtc_schedule() in main.c, without the register synchronization
+static void rtc_schedule(uint16_t seconds)
+{
+    uint16_t wakeup = rtc_synced + seconds;
+    
+    if ((uint16_t)(wakeup - rtc_count - 1) >= seconds)
+    {
+        wakeup = rtc_count + 1;
+    }
+    rtc_compare = wakeup;
+}
+
+static void redraw(void)
+{
+    render();
+    rtc_schedule(next_wakeup());
+}
+
+// Count the RTC up a second at a time, waking on compare matches
+static void wait_seconds(uint32_t seconds)
+{
+    while (seconds--)
+    {
+        if (++rtc_count == rtc_compare)
+        {
+            rtc_sync();
+            redraw();
+        }
+    }
+}
+
+static void print_uart(void)
+{
+    const char *out = host_uart_take();
+    
+    while (*out)
+    {
+        size_t len = strcspn(out, "\r\n");
+        
+        if (len)
+        {
+            printf("uart: %.*s\n", (int)len, out);
+        }
+        out += len;
+        out += strspn(out, "\r\n");
+    }
+}
+
+// Read an LCD row as printable text
+static void read_row(uint8_t y, char *row)
+{
+    hd44780_row(host_lcd(), y, row, LCD_DISP_LENGTH);
+    // CGRAM glyphs and the upper half of the ROM have no ASCII form
+    for (uint8_t x = 0; x < LCD_DISP_LENGTH; x++)
+    {
+        if (((uint8_t)row[x] < ' ') || ((uint8_t)row[x] > '~'))
+        {
+            row[x] = '#';
+        }
+    }
+}
+
+static void print_lcd(void)
+{
+    char row[LCD_DISP_LENGTH];
+    
+    for (uint8_t y = 0; y < LCD_LINES; y++)
+    {
+        read_row(y, row);
+        printf("lcd: |%.*s|\n", (int)sizeof(row), row);
+    }
+    printf("backlight: %u buzzer: %u\n", host_backlight(), host_buzzer());
+}
+
+// Compare an LCD row with the expected text, trailing spaces ignored
+static uint8_t expect_row(const char *args)
+{
+    char row[LCD_DISP_LENGTH + 1];
+    char *end;
+    unsigned long y = strtoul(args, &end, 10);
+    const char *text = (*end == ' ') ? end + 1 : end;
+    size_t len;
+    
+    if ((end == args) || (y >= LCD_LINES))
+    {
+        fprintf(stderr, "sim: bad row in 'expect %s'\n", args);
+        return 0;
+    }
+    read_row(y, row);
+    len = LCD_DISP_LENGTH;
+    while (len && (row[len - 1] == ' '))
+    {
+        len--;
+    }
+    row[len] = '\0';
+    
+    if (strcmp(row, text) != 0)
+    {
+        fprintf(stderr, "sim: row %lu is '%s', expected '%s'\n", y, row, text);
+        return 0;
+    }
+    return 1;
+}
+
+static void print_stats(void)
+{
+    hd44780_t *lcd = host_lcd();
+    const hd44780_stats_t *st = &lcd->stats;
+    
+    printf("stats: nibbles=%lu instructions=%lu data_writes=%lu "
+            "data_reads=%lu status_reads=%lu busy_polls=%lu violations=%lu "
+            "busy_us=%llu elapsed_us=%llu\n",
+            (unsigned long)st->nibbles, (unsigned long)st->instructions,
+            (unsigned long)st->data_writes, (unsigned long)st->data_reads,
+            (unsigned long)st->status_reads, (unsigned long)st->busy_polls,
+            (unsigned long)st->violations,
+            (unsigned long long)(st->busy_ns / 1000),
+            (unsigned long long)(st->elapsed_ns / 1000));
+    hd44780_stats_reset(lcd);
+}
+
+int main(void)
+{
+    char line[SCRIPT_LINE_LEN];
+    
+    hal_init();
+    lcd_init(LCD_DISP_ON);
+    hal_backlight(1);
+    USART0_init();
+    app_init();
+    
+    // RTC starts with the first wakeup after a second
+    rtc_count = 0;
+    rtc_synced = 0;
+    rtc_compare = 1;
+    
+    while (fgets(line, sizeof(line), stdin))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        
+        if (strncmp(line, "wait ", 5) == 0)
+        {
+            wait_seconds(strtoul(line + 5, NULL, 10));
+        }
+        else if (strcmp(line, "click") == 0)
+        {
+            rtc_sync();
+            app_next_view();
+            redraw();
+        }
+        else if (strcmp(line, "long") == 0)
+        {
+            hal_backlight_toggle();
+        }
+        else if (strncmp(line, "send ", 5) == 0)
+        {
+            host_uart_receive(line + 5);
+            host_uart_receive("\r");
+            rtc_sync();
+            if (serial_task())
+            {
+                redraw();
+            }
+        }
+        else if (strcmp(line, "show") == 0)
+        {
+            print_lcd();
+        }
+        else if (strncmp(line, "expect ", 7) == 0)
+        {
+            if (!expect_row(line + 7))
+            {
+                return 1;
+            }
+        }
+        else if (strcmp(line, "stats") == 0)
+        {
+            print_stats();
+        }
+        else if ((line[0] != '#') && (line[0] != '\0'))
+        {
+            fprintf(stderr, "sim: unknown action '%s'\n", line);
+            return 1;
+        }
+        print_uart();
+    }
+    return 0;
+}
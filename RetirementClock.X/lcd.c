@@ -12,8 +12,17 @@
        Originally based on Volker Oth's lcd library,
        changed lcd_init(), added additional constants for lcd_command(),
        added 4-bit I/O mode, improved and optimized code.
-       Library can be operated in memory mapped mode (LCD_IO_MODE=0) or in 
-       4-bit IO port mode (LCD_IO_MODE=1). 8-bit IO port mode not supported.
+       Library can be operated in memory mapped mode (LCD_IO_MODE=0), in 
+       4-bit IO port mode (LCD_IO_MODE=1) or in 8-bit IO port mode 
+       (LCD_IO_MODE=2) with the data bus on one whole port.
+       With LCD_HAL_BUS=1 the 4-bit bus is driven through hal.h instead of
+       port pins, which is how the host simulator builds it.
+       With LCD_ASYNC=1 instructions and data are queued and a TCB1
+       interrupt sends them once the previous one has been executed.
+       With LCD_WRITE_ONLY=1 RW is held low and every write is followed
+       by the execution time of the instruction instead of polling the
+       busy flag, and LCD_ASYNC defaults to 0. Setting both is an error.
+       Both track the address counter in software.
        
        Memory mapped mode compatible with Kanda STK200, but supports also
        generation of R/W signal through A8 address line.
@@ -25,11 +34,26 @@
 #define F_CPU 3333333
 
 #include <inttypes.h>
+#include <string.h>
 #include <avr/io.h>
 #include <avr/pgmspace.h>
 #include <util/delay.h>
 //#include <avr/sfr_defs.h>
 #include "lcd.h"
+#include "profile.h"
+#if LCD_HAL_BUS
+#include "hal.h"
+#endif
+#if LCD_HAL_BUS && (LCD_IO_MODE == 2)
+#error "the HAL bus is 4-bit, use LCD_IO_MODE 1 with LCD_HAL_BUS"
+#endif
+#if LCD_ASYNC
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#endif
+#if LCD_WRITE_ONLY
+#include <util/delay_basic.h>
+#endif
 
 
 
@@ -39,6 +63,12 @@
 //#define DDR(x) (*(&x - 1))      /* address of data direction register of port x */
 #define _BV(bit) (1 << (bit))
 
+/* 1: wait for the busy flag and read the address counter from the LCD,
+   0: the LCD is only written, the address counter is tracked in software */
+#define LCD_READ_BACK   (!LCD_ASYNC && !LCD_WRITE_ONLY)
+
+/* CPU cycles (and TCB1 ticks) for a delay in micro seconds, rounded up */
+#define LCD_CYCLES(us)  ((uint16_t)(((uint32_t)(us) * (F_CPU / 1000UL) + 999) / 1000))
 
 
 
@@ -51,9 +81,38 @@
 #define lcd_rw_low()    LCD_RW_PORT.OUT &= ~_BV(LCD_RW_PIN)
 #define lcd_rs_high()   LCD_RS_PORT.OUT |=  _BV(LCD_RS_PIN)
 #define lcd_rs_low()    LCD_RS_PORT.OUT &= ~_BV(LCD_RS_PIN)
+
+/*
+ * The data lines are on four contiguous pins of one port when
+ * lcd_data_fast() is true. Each nibble is then a single masked write to
+ * (or read from) that port instead of four separate pin operations.
+ * The pin check is done by the preprocessor, the port check is a constant
+ * expression the compiler folds away.
+ */
+#if (LCD_DATA1_PIN == LCD_DATA0_PIN+1) && (LCD_DATA2_PIN == LCD_DATA0_PIN+2) && (LCD_DATA3_PIN == LCD_DATA0_PIN+3)
+#define LCD_DATA_CONTIGUOUS 1
+#else
+#define LCD_DATA_CONTIGUOUS 0
+#endif
+#define LCD_DATA_MASK   ((uint8_t)(0x0F << LCD_DATA0_PIN))
+#define lcd_data_fast() ( LCD_DATA_CONTIGUOUS && ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) \
+                       && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT ) )
+
+/* move high/low nibble of a byte to the data pins and back */
+#if LCD_DATA0_PIN == 4
+#define lcd_high_nibble_out(d)  ((d) & 0xF0)
+#define lcd_low_nibble_out(d)   ((uint8_t)((d) << 4))
+#define lcd_high_nibble_in(p)   ((p) & 0xF0)
+#define lcd_low_nibble_in(p)    ((p) >> 4)
+#else
+#define lcd_high_nibble_out(d)  ((uint8_t)((((d) >> 4) & 0x0F) << LCD_DATA0_PIN))
+#define lcd_low_nibble_out(d)   ((uint8_t)(((d) & 0x0F) << LCD_DATA0_PIN))
+#define lcd_high_nibble_in(p)   ((uint8_t)((((p) >> LCD_DATA0_PIN) & 0x0F) << 4))
+#define lcd_low_nibble_in(p)    (((p) >> LCD_DATA0_PIN) & 0x0F)
+#endif
 #endif
 
-#if LCD_IO_MODE
+#if LCD_IO_MODE == 1
 #if LCD_LINES==1
 #define LCD_FUNCTION_DEFAULT    LCD_FUNCTION_4BIT_1LINE 
 #else
@@ -67,6 +126,49 @@
 #endif
 #endif
 
+#if LCD_FRAMEBUFFER
+/* framebuffer drawn by lcd_fb_*() and copy of what the controller displays */
+static char lcd_fb[LCD_LINES][LCD_DISP_LENGTH];
+static char lcd_glass[LCD_LINES][LCD_DISP_LENGTH];
+static uint8_t lcd_glass_valid;
+static uint8_t lcd_fb_x;
+static uint8_t lcd_fb_y;
+#endif
+
+#if LCD_ASYNC
+/* queued bytes, LCD_QUEUE_DATA set for data (RS=1) */
+#define LCD_QUEUE_DATA  0x100
+static uint16_t lcd_queue[LCD_QUEUE_SIZE];
+static volatile uint8_t lcd_queue_head;     /* next free entry */
+static volatile uint8_t lcd_queue_tail;     /* next entry to send */
+static volatile uint8_t lcd_sending;        /* TCB1 is timing an instruction */
+#endif
+
+#if LCD_GLYPH_CACHE
+/* glyph loaded in each CGRAM slot, and the slots by last use, latest first */
+static const uint8_t *lcd_glyph_slot[8];
+static uint8_t lcd_glyph_lru[8];
+static uint16_t lcd_glyph_hit_count;
+static uint16_t lcd_glyph_miss_count;
+#endif
+
+#if !LCD_READ_BACK
+static uint8_t lcd_addr;                    /* software copy of the address counter */
+
+/* execution time in CPU cycles of each instruction, by its highest set bit */
+static const uint16_t lcd_exec_table[8] PROGMEM =
+{
+    LCD_CYCLES(LCD_DELAY_EXEC_CLEAR),       /* DB0: clear display          */
+    LCD_CYCLES(LCD_DELAY_EXEC_CLEAR),       /* DB1: return home            */
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB2: entry mode set         */
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB3: display on/off control */
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB4: cursor or display shift*/
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB5: function set           */
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB6: set CGRAM address      */
+    LCD_CYCLES(LCD_DELAY_EXEC),             /* DB7: set DDRAM address      */
+};
+#endif
+
 #if LCD_CONTROLLER_KS0073
 #if LCD_LINES==4
 
@@ -80,7 +182,7 @@
 /* 
 ** function prototypes 
 */
-#if LCD_IO_MODE
+#if LCD_IO_MODE && !LCD_HAL_BUS
 static void toggle_e(void);
 #endif
 
@@ -96,7 +198,7 @@ the number of loops is calculated at compile-time from MCU clock frequency
 #define delay(us)  _delay_us(us) 
 
 
-#if LCD_IO_MODE
+#if LCD_IO_MODE && !LCD_HAL_BUS
 /* toggle Enable Pin to initiate write */
 static void toggle_e(void)
 {
@@ -114,7 +216,33 @@ Input:    data   byte to write to LCD
                  0: write instruction
 Returns:  none
 *************************************************************************/
-#if LCD_IO_MODE
+#if LCD_HAL_BUS
+static void lcd_write(uint8_t data,uint8_t rs) 
+{
+    /* high nibble first, E is pulsed by the HAL */
+    hal_lcd_nibble_out(data >> 4, rs);
+    hal_lcd_nibble_out(data & 0x0F, rs);
+}
+#elif LCD_IO_MODE == 2
+static void lcd_write(uint8_t data,uint8_t rs) 
+{
+    if (rs) {        /* write data        (RS=1, RW=0) */
+       lcd_rs_high();
+    } else {         /* write instruction (RS=0, RW=0) */
+       lcd_rs_low();
+    }
+#if LCD_READ_BACK
+    lcd_rw_low();    /* RW=0  write mode      */
+
+    /* configure data pins as output */
+    LCD_DATA_PORT.DIR = 0xFF;
+#endif
+
+    /* whole byte at once */
+    LCD_DATA_PORT.OUT = data;
+    lcd_e_toggle();
+}
+#elif LCD_IO_MODE
 static void lcd_write(uint8_t data,uint8_t rs) 
 {
     unsigned char dataBits ;
@@ -125,33 +253,40 @@ static void lcd_write(uint8_t data,uint8_t rs)
     } else {         /* write instruction (RS=0, RW=0) */
        lcd_rs_low();
     }
+#if LCD_READ_BACK
     lcd_rw_low();    /* RW=0  write mode      */
+#endif
 
-    if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
-      && (LCD_DATA0_PIN == 0) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) )
+    if ( lcd_data_fast() )
     {
+#if LCD_READ_BACK
         /* configure data pins as output */
-        LCD_DATA0_PORT.DIR |= 0x0F;
+        LCD_DATA0_PORT.DIR |= LCD_DATA_MASK;
+#endif
 
         /* output high nibble first */
-        dataBits = LCD_DATA0_PORT.OUT & 0xF0;
-        LCD_DATA0_PORT.OUT = dataBits |((data>>4)&0x0F);
+        dataBits = LCD_DATA0_PORT.OUT & ~LCD_DATA_MASK;
+        LCD_DATA0_PORT.OUT = dataBits | lcd_high_nibble_out(data);
         lcd_e_toggle();
 
         /* output low nibble */
-        LCD_DATA0_PORT.OUT = dataBits | (data&0x0F);
+        LCD_DATA0_PORT.OUT = dataBits | lcd_low_nibble_out(data);
         lcd_e_toggle();
 
+#if LCD_READ_BACK
         /* all data pins high (inactive) */
-        LCD_DATA0_PORT.OUT = dataBits | 0x0F;
+        LCD_DATA0_PORT.OUT = dataBits | LCD_DATA_MASK;
+#endif
     }
     else
     {
+#if LCD_READ_BACK
         /* configure data pins as output */
         LCD_DATA0_PORT.DIR |= _BV(LCD_DATA0_PIN);
         LCD_DATA1_PORT.DIR |= _BV(LCD_DATA1_PIN);
         LCD_DATA2_PORT.DIR |= _BV(LCD_DATA2_PIN);
         LCD_DATA3_PORT.DIR |= _BV(LCD_DATA3_PIN);
+#endif
         
         /* output high nibble first */
         LCD_DATA3_PORT.OUT &= ~_BV(LCD_DATA3_PIN);
@@ -175,11 +310,13 @@ static void lcd_write(uint8_t data,uint8_t rs)
     	if(data & 0x01) LCD_DATA0_PORT.OUT |= _BV(LCD_DATA0_PIN);
         lcd_e_toggle();        
         
+#if LCD_READ_BACK
         /* all data pins high (inactive) */
         LCD_DATA0_PORT.OUT |= _BV(LCD_DATA0_PIN);
         LCD_DATA1_PORT.OUT |= _BV(LCD_DATA1_PIN);
         LCD_DATA2_PORT.OUT |= _BV(LCD_DATA2_PIN);
         LCD_DATA3_PORT.OUT |= _BV(LCD_DATA3_PIN);
+#endif
     }
 }
 #else
@@ -189,13 +326,24 @@ static void lcd_write(uint8_t data,uint8_t rs)
 #endif
 
 
+#if LCD_READ_BACK
 /*************************************************************************
 Low-level function to read byte from LCD controller
 Input:    rs     1: read data    
                  0: read busy flag / address counter
 Returns:  byte read from LCD controller
 *************************************************************************/
-#if LCD_IO_MODE
+#if LCD_HAL_BUS
+static uint8_t lcd_read(uint8_t rs) 
+{
+    uint8_t data;
+    
+    /* high nibble first */
+    data = hal_lcd_nibble_in(rs) << 4;
+    data |= hal_lcd_nibble_in(rs);
+    return data;
+}
+#elif LCD_IO_MODE == 2
 static uint8_t lcd_read(uint8_t rs) 
 {
     uint8_t data;
@@ -207,21 +355,40 @@ static uint8_t lcd_read(uint8_t rs)
         lcd_rs_low();                        /* RS=0: read busy flag */
     lcd_rw_high();                           /* RW=1  read mode      */
     
-    if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
-      && ( LCD_DATA0_PIN == 0 )&& (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) )
+    LCD_DATA_PORT.DIR = 0x00;                /* configure data pins as input */
+    
+    lcd_e_high();
+    lcd_e_delay();
+    data = LCD_DATA_PORT.IN;                 /* whole byte at once   */
+    lcd_e_low();
+    return data;
+}
+#elif LCD_IO_MODE
+static uint8_t lcd_read(uint8_t rs) 
+{
+    uint8_t data;
+    
+    
+    if (rs)
+        lcd_rs_high();                       /* RS=1: read data      */
+    else
+        lcd_rs_low();                        /* RS=0: read busy flag */
+    lcd_rw_high();                           /* RW=1  read mode      */
+    
+    if ( lcd_data_fast() )
     {
-        LCD_DATA0_PORT.DIR &= 0xF0;         /* configure data pins as input */
+        LCD_DATA0_PORT.DIR &= ~LCD_DATA_MASK;   /* configure data pins as input */
         
         lcd_e_high();
         lcd_e_delay();        
-        data = LCD_DATA0_PORT.IN << 4;     /* read high nibble first */
+        data = lcd_high_nibble_in(LCD_DATA0_PORT.IN);   /* read high nibble first */
         lcd_e_low();
         
         lcd_e_delay();                       /* Enable 500ns low       */
         
         lcd_e_high();
         lcd_e_delay();
-        data |= LCD_DATA0_PORT.IN &0x0F;    /* read low nibble        */
+        data |= lcd_low_nibble_in(LCD_DATA0_PORT.IN);   /* read low nibble        */
         lcd_e_low();
     }
     else
@@ -270,6 +437,7 @@ static uint8_t lcd_waitbusy(void)
 {
     register uint8_t c;
     
+    PROFILE_ENTER(PROF_LCD_WAITBUSY);
     /* wait until busy flag is cleared */
     while ( (c=lcd_read(0)) & (1<<LCD_BUSY)) {}
     
@@ -277,9 +445,157 @@ static uint8_t lcd_waitbusy(void)
     delay(LCD_DELAY_BUSY_FLAG);
 
     /* now read the address counter */
-    return (lcd_read(0));  // return address counter
+    c = lcd_read(0);
+    PROFILE_EXIT(PROF_LCD_WAITBUSY);
+    return (c);  // return address counter
     
 }/* lcd_waitbusy */
+#endif
+
+
+#if !LCD_READ_BACK
+/*************************************************************************
+Execution time of an instruction in CPU cycles, looked up by the
+instruction's highest set bit. Data writes don't come here, their time is
+the constant LCD_DELAY_EXEC_DATA.
+*************************************************************************/
+static uint16_t lcd_exec_cycles(uint8_t cmd)
+{
+    uint8_t i = 7;
+
+    while ( i && !(cmd & (1<<i)) )
+        i--;
+    return pgm_read_word(&lcd_exec_table[i]);
+}
+
+
+/*************************************************************************
+Update the software address counter the way the LCD will on this write.
+Assumes the default incrementing entry mode.
+Input:    data   byte written to LCD
+          rs     1: data written
+                 0: instruction written
+*************************************************************************/
+static void lcd_track(uint8_t data, uint8_t rs)
+{
+    if (rs)
+    {
+        /* increment, skipping the gap between the lines */
+        lcd_addr++;
+#if LCD_LINES==1
+        if ( lcd_addr == 0x50 )
+            lcd_addr = 0;
+#else
+        if ( lcd_addr == 0x28 )
+            lcd_addr = 0x40;
+        else if ( lcd_addr == 0x68 )
+            lcd_addr = 0;
+#endif
+    }
+    else if ( data & (1<<LCD_DDRAM) )
+        lcd_addr = data & 0x7F;
+    else if ( data & (1<<LCD_CGRAM) )
+        lcd_addr = data & 0x3F;
+    else if ( data < (1<<LCD_ENTRY_MODE) )      /* clear display, return home */
+        lcd_addr = 0;
+
+}/* lcd_track */
+#endif
+
+
+#if LCD_ASYNC
+
+
+/*************************************************************************
+Send the next queued byte, the previous one has been executed by now.
+TCB1 then times the execution of the byte just sent. It is restarted after
+the write, so a late interrupt never shortens the following wait.
+Runs with interrupts disabled.
+*************************************************************************/
+static void lcd_step(void)
+{
+    uint8_t tail = lcd_queue_tail;
+    uint16_t entry;
+
+
+    TCB1.INTFLAGS = TCB_CAPT_bm;
+    if (tail == lcd_queue_head)
+    {
+        /* queue drained, stop until the next lcd_enqueue() */
+        TCB1.CTRLA = 0;
+        lcd_sending = 0;
+        return;
+    }
+    entry = lcd_queue[tail];
+    lcd_queue_tail = (tail + 1) & (LCD_QUEUE_SIZE - 1);
+    
+    lcd_write((uint8_t)entry, (entry & LCD_QUEUE_DATA) != 0);
+    if (entry & LCD_QUEUE_DATA)
+        TCB1.CCMP = LCD_CYCLES(LCD_DELAY_EXEC_DATA);
+    else
+        TCB1.CCMP = lcd_exec_cycles((uint8_t)entry);
+    TCB1.CNT = 0;
+
+}/* lcd_step */
+
+
+/* TCB1 compare, the last byte sent has been executed. TCB1 counts CPU cycles */
+ISR(TCB1_INT_vect)
+{
+    PROFILE_ENTER(PROF_ISR_TCB1);
+    lcd_step();
+    PROFILE_EXIT(PROF_ISR_TCB1);
+}
+
+
+/*************************************************************************
+Take a step whose time has come without waiting for the interrupt, which
+may be disabled. Used where the queue has to drain before going on.
+*************************************************************************/
+static void lcd_poll(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if ( lcd_sending && (TCB1.INTFLAGS & TCB_CAPT_bm) )
+            lcd_step();
+    }
+}
+
+
+/*************************************************************************
+Append a byte to the queue and start sending if the LCD is idle.
+The address counter is tracked here, in the order the LCD will see it.
+Input:    data   byte to write to LCD
+          rs     1: write data    
+                 0: write instruction
+*************************************************************************/
+static void lcd_enqueue(uint8_t data, uint8_t rs)
+{
+    uint8_t head = lcd_queue_head;
+    uint8_t next = (head + 1) & (LCD_QUEUE_SIZE - 1);
+
+
+    lcd_track(data, rs);
+
+    /* queue full, wait for the oldest entry to go out */
+    while ( next == lcd_queue_tail )
+        lcd_poll();
+
+    lcd_queue[head] = rs ? (data | LCD_QUEUE_DATA) : data;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        lcd_queue_head = next;
+        if ( !lcd_sending )
+        {
+            /* send it right away, TCB1 takes over from here */
+            lcd_sending = 1;
+            lcd_step();
+            TCB1.CTRLA = TCB_CLKSEL_CLKDIV1_gc | TCB_ENABLE_bm;
+        }
+    }
+
+}/* lcd_enqueue */
+#endif
 
 
 /*************************************************************************
@@ -337,8 +653,16 @@ Returns: none
 *************************************************************************/
 void lcd_command(uint8_t cmd)
 {
+#if LCD_ASYNC
+    lcd_enqueue(cmd,0);
+#elif LCD_WRITE_ONLY
+    lcd_track(cmd,0);
+    lcd_write(cmd,0);
+    _delay_loop_2(lcd_exec_cycles(cmd) / 4);   /* 4 cycles per loop */
+#else
     lcd_waitbusy();
     lcd_write(cmd,0);
+#endif
 }
 
 
@@ -349,8 +673,17 @@ Returns: none
 *************************************************************************/
 void lcd_data(uint8_t data)
 {
+#if LCD_ASYNC
+    lcd_enqueue(data,1);
+#elif LCD_WRITE_ONLY
+    /* all data writes take the same time, no table lookup */
+    lcd_track(data,1);
+    lcd_write(data,1);
+    delay(LCD_DELAY_EXEC_DATA);
+#else
     lcd_waitbusy();
     lcd_write(data,1);
+#endif
 }
 
 
@@ -390,7 +723,11 @@ void lcd_gotoxy(uint8_t x, uint8_t y)
 *************************************************************************/
 int lcd_getxy(void)
 {
+#if !LCD_READ_BACK
+    return lcd_addr;
+#else
     return lcd_waitbusy();
+#endif
 }
 
 
@@ -400,6 +737,11 @@ Clear display and set cursor to home position
 void lcd_clrscr(void)
 {
     lcd_command(1<<LCD_CLR);
+#if LCD_FRAMEBUFFER
+    /* controller now shows only spaces */
+    memset(lcd_glass, ' ', sizeof(lcd_glass));
+    lcd_glass_valid = 1;
+#endif
 }
 
 
@@ -412,6 +754,99 @@ void lcd_home(void)
 }
 
 
+/*************************************************************************
+Load a custom character into CGRAM slot code (0-7). The glyph is 8 rows 
+from the top with the dots in bits 4..0. The cursor is put back after.
+*************************************************************************/
+void lcd_custom_char(uint8_t code, const uint8_t *glyph)
+{
+    uint8_t addr = lcd_getxy();
+    uint8_t i;
+
+
+    lcd_command((1<<LCD_CGRAM) | ((code & 0x07) << 3));
+    for (i = 0; i < 8; i++)
+        lcd_data(glyph[i]);
+    lcd_command((1<<LCD_DDRAM) | addr);
+#if LCD_GLYPH_CACHE
+    lcd_glyph_slot[code & 0x07] = 0;
+#endif
+
+}/* lcd_custom_char */
+
+
+/*************************************************************************
+Load a custom character from program memory into CGRAM slot code (0-7)
+*************************************************************************/
+void lcd_custom_char_p(uint8_t code, const uint8_t *progmem_glyph)
+{
+    uint8_t addr = lcd_getxy();
+    uint8_t i;
+
+
+    lcd_command((1<<LCD_CGRAM) | ((code & 0x07) << 3));
+    for (i = 0; i < 8; i++)
+        lcd_data(pgm_read_byte(progmem_glyph++));
+    lcd_command((1<<LCD_DDRAM) | addr);
+#if LCD_GLYPH_CACHE
+    lcd_glyph_slot[code & 0x07] = 0;
+#endif
+
+}/* lcd_custom_char_p */
+
+
+#if LCD_GLYPH_CACHE
+/*************************************************************************
+Get the character code showing a glyph from program memory. On a miss the
+least recently used slot is loaded with it.
+Input:    glyph in program memory, 8 rows
+Returns:  character code of the slot, see LCD_CGRAM_CHAR()
+*************************************************************************/
+char lcd_glyph(const uint8_t *progmem_glyph)
+{
+    uint8_t i, slot;
+
+
+    /* search by last use, ending at the least recently used slot */
+    for (i = 0; i < 7; i++)
+    {
+        if ( lcd_glyph_slot[lcd_glyph_lru[i]] == progmem_glyph )
+            break;
+    }
+    slot = lcd_glyph_lru[i];
+    if ( lcd_glyph_slot[slot] == progmem_glyph )
+    {
+        lcd_glyph_hit_count++;
+    }
+    else
+    {
+        lcd_glyph_miss_count++;
+        lcd_custom_char_p(slot, progmem_glyph);
+        lcd_glyph_slot[slot] = progmem_glyph;
+    }
+    
+    /* the slot is now the latest used */
+    for ( ; i > 0; i--)
+        lcd_glyph_lru[i] = lcd_glyph_lru[i-1];
+    lcd_glyph_lru[0] = slot;
+    return LCD_CGRAM_CHAR(slot);
+
+}/* lcd_glyph */
+
+
+uint16_t lcd_glyph_hits(void)
+{
+    return lcd_glyph_hit_count;
+}
+
+
+uint16_t lcd_glyph_misses(void)
+{
+    return lcd_glyph_miss_count;
+}
+#endif
+
+
 /*************************************************************************
 Display character at current cursor position 
 Input:    character to be displayed                                       
@@ -422,6 +857,30 @@ void lcd_putc(char c)
     uint8_t pos;
 
 
+#if !LCD_READ_BACK
+    pos = lcd_addr;         // address counter as tracked by lcd_track()
+    if (c=='\n')
+    {
+        lcd_newline(pos);
+    }
+    else
+    {
+#if LCD_WRAP_LINES==1
+        /* past the end of a visible line, continue on the next one */
+        if ( (pos == LCD_START_LINE1+LCD_DISP_LENGTH)
+#if LCD_LINES>1
+          || (pos == LCD_START_LINE2+LCD_DISP_LENGTH)
+#endif
+#if LCD_LINES==4
+          || (pos == LCD_START_LINE3+LCD_DISP_LENGTH)
+          || (pos == LCD_START_LINE4+LCD_DISP_LENGTH)
+#endif
+           )
+            lcd_newline(pos);
+#endif
+        lcd_data(c);
+    }
+#else
     pos = lcd_waitbusy();   // read busy-flag and address counter
     if (c=='\n')
     {
@@ -455,6 +914,7 @@ void lcd_putc(char c)
 #endif
         lcd_write(c, 1);
     }
+#endif
 
 }/* lcd_putc */
 
@@ -493,6 +953,153 @@ void lcd_puts_p(const char *progmem_s)
 }/* lcd_puts_p */
 
 
+#if LCD_ASYNC
+/*************************************************************************
+Check whether queued instructions and data are still being sent
+Returns:  nonzero until the last queued byte has been executed
+*************************************************************************/
+uint8_t lcd_busy(void)
+{
+    return lcd_sending;
+}
+
+
+/*************************************************************************
+Wait until all queued instructions and data have been executed
+*************************************************************************/
+void lcd_wait(void)
+{
+    while ( lcd_sending )
+        lcd_poll();
+}
+#endif
+
+
+#if LCD_FRAMEBUFFER
+/*************************************************************************
+Clear framebuffer and set framebuffer cursor to home position
+*************************************************************************/
+void lcd_fb_clear(void)
+{
+    memset(lcd_fb, ' ', sizeof(lcd_fb));
+    lcd_fb_x = 0;
+    lcd_fb_y = 0;
+}
+
+
+/*************************************************************************
+Set framebuffer cursor to specified position
+Input:    x  horizontal position  (0: left most position)
+          y  vertical position    (0: first line)
+Returns:  none
+*************************************************************************/
+void lcd_fb_gotoxy(uint8_t x, uint8_t y)
+{
+    lcd_fb_x = x;
+    lcd_fb_y = y;
+}
+
+
+/*************************************************************************
+Draw character into framebuffer at cursor position
+Input:    character to be drawn, '\n' moves to start of next line
+Returns:  none
+*************************************************************************/
+void lcd_fb_putc(char c)
+{
+    if (c=='\n')
+    {
+        lcd_fb_x = 0;
+        if ( ++lcd_fb_y >= LCD_LINES )
+            lcd_fb_y = 0;
+    }
+    else if ( (lcd_fb_x < LCD_DISP_LENGTH) && (lcd_fb_y < LCD_LINES) )
+    {
+        lcd_fb[lcd_fb_y][lcd_fb_x++] = c;
+    }
+
+}/* lcd_fb_putc */
+
+
+/*************************************************************************
+Draw string into framebuffer
+Input:    string to be drawn
+Returns:  none
+*************************************************************************/
+void lcd_fb_puts(const char *s)
+{
+    register char c;
+
+    while ( (c = *s++) ) {
+        lcd_fb_putc(c);
+    }
+
+}/* lcd_fb_puts */
+
+
+/*************************************************************************
+Draw string from program memory into framebuffer
+Input:    string from program memory to be drawn
+Returns:  none
+*************************************************************************/
+void lcd_fb_puts_p(const char *progmem_s)
+{
+    register char c;
+
+    while ( (c = pgm_read_byte(progmem_s++)) ) {
+        lcd_fb_putc(c);
+    }
+
+}/* lcd_fb_puts_p */
+
+
+/*************************************************************************
+Transfer changed framebuffer cells to the LCD controller.
+A run of changed cells costs one address command plus one data write per
+cell. A single unchanged cell between two changed ones is rewritten instead
+of skipped, since that costs the same as the address command it saves.
+*************************************************************************/
+void lcd_flush(void)
+{
+    uint8_t x, y;
+    uint8_t cursor;     /* column the controller writes to next, 0xFF: elsewhere */
+
+    for (y = 0; y < LCD_LINES; y++)
+    {
+        cursor = 0xFF;
+        for (x = 0; x < LCD_DISP_LENGTH; x++)
+        {
+            char c = lcd_fb[y][x];
+
+            if ( lcd_glass_valid && (c == lcd_glass[y][x]) )
+            {
+                /* unchanged, unless it bridges two changed cells */
+                if ( (cursor != x) || (x+1 >= LCD_DISP_LENGTH)
+                  || (lcd_fb[y][x+1] == lcd_glass[y][x+1]) )
+                    continue;
+            }
+            if (cursor != x)
+                lcd_gotoxy(x, y);
+            lcd_data(c);
+            lcd_glass[y][x] = c;
+            cursor = x+1;
+        }
+    }
+    lcd_glass_valid = 1;
+
+}/* lcd_flush */
+
+
+/*************************************************************************
+Forget the known controller contents, next lcd_flush() rewrites all cells
+*************************************************************************/
+void lcd_fb_invalidate(void)
+{
+    lcd_glass_valid = 0;
+}
+#endif
+
+
 /*************************************************************************
 Initialize display and select type of cursor 
 Input:    dispAttr LCD_DISP_OFF            display off
@@ -503,7 +1110,48 @@ Returns:  none
 *************************************************************************/
 void lcd_init(uint8_t dispAttr)
 {
-#if LCD_IO_MODE
+#if LCD_HAL_BUS
+    /*
+     *  Initialize LCD to 4 bit I/O mode through the HAL
+     */
+    hal_lcd_bus_init();
+    delay(LCD_DELAY_BOOTUP);             /* wait 16ms or more after power-on       */
+    
+    /* initial write to lcd is 8bit, three times */
+    hal_lcd_nibble_out(LCD_FUNCTION_8BIT_1LINE >> 4, 0);
+    delay(LCD_DELAY_INIT);               /* delay, busy flag can't be checked here */
+    hal_lcd_nibble_out(LCD_FUNCTION_8BIT_1LINE >> 4, 0);
+    delay(LCD_DELAY_INIT_REP);           /* delay, busy flag can't be checked here */
+    hal_lcd_nibble_out(LCD_FUNCTION_8BIT_1LINE >> 4, 0);
+    delay(LCD_DELAY_INIT_REP);           /* delay, busy flag can't be checked here */
+    
+    /* now configure for 4bit mode */
+    hal_lcd_nibble_out(LCD_FUNCTION_4BIT_1LINE >> 4, 0);
+    delay(LCD_DELAY_INIT_4BIT);          /* some displays need this additional delay */
+#elif LCD_IO_MODE == 2
+    /*
+     *  Initialize LCD to 8 bit I/O mode
+     */
+    LCD_DATA_PORT.DIR  = 0xFF;
+    LCD_RS_PORT.DIR   |= _BV(LCD_RS_PIN);
+    LCD_RW_PORT.DIR   |= _BV(LCD_RW_PIN);
+    LCD_E_PORT.DIR    |= _BV(LCD_E_PIN);
+#if !LCD_READ_BACK
+    lcd_rw_low();                        /* RW stays low, the LCD is only written */
+#endif
+    delay(LCD_DELAY_BOOTUP);             /* wait 16ms or more after power-on       */
+    
+    /* function set 8bit, three times */
+    LCD_DATA_PORT.OUT = LCD_FUNCTION_8BIT_1LINE;
+    lcd_e_toggle();
+    delay(LCD_DELAY_INIT);               /* delay, busy flag can't be checked here */
+    lcd_e_toggle();
+    delay(LCD_DELAY_INIT_REP);           /* delay, busy flag can't be checked here */
+    lcd_e_toggle();
+    delay(LCD_DELAY_INIT_REP);           /* delay, busy flag can't be checked here */
+    
+    /* the LCD stays in 8 bit mode, from now on lcd_command() can be used */
+#elif LCD_IO_MODE
     /*
      *  Initialize LCD to 4 bit I/O mode
      */
@@ -516,11 +1164,10 @@ void lcd_init(uint8_t dispAttr)
         /* configure all port bits as output (all LCD lines on same port) */
         LCD_DATA0_PORT.DIR |= 0x7F;
     }
-    else if ( ( &LCD_DATA0_PORT == &LCD_DATA1_PORT) && ( &LCD_DATA1_PORT == &LCD_DATA2_PORT ) && ( &LCD_DATA2_PORT == &LCD_DATA3_PORT )
-           && (LCD_DATA0_PIN == 0 ) && (LCD_DATA1_PIN == 1) && (LCD_DATA2_PIN == 2) && (LCD_DATA3_PIN == 3) )
+    else if ( lcd_data_fast() )
     {
         /* configure all port bits as output (all LCD data lines on same port, but control lines on different ports) */
-        LCD_DATA0_PORT.DIR |= 0x0F;
+        LCD_DATA0_PORT.DIR |= LCD_DATA_MASK;
         LCD_RS_PORT.DIR    |= _BV(LCD_RS_PIN);
         LCD_RW_PORT.DIR    |= _BV(LCD_RW_PIN);
         LCD_E_PORT.DIR     |= _BV(LCD_E_PIN);
@@ -536,6 +1183,9 @@ void lcd_init(uint8_t dispAttr)
         LCD_DATA2_PORT.DIR |= _BV(LCD_DATA2_PIN);
         LCD_DATA3_PORT.DIR |= _BV(LCD_DATA3_PIN);
     }
+#if !LCD_READ_BACK
+    lcd_rw_low();                        /* RW stays low, the LCD is only written */
+#endif
     delay(LCD_DELAY_BOOTUP);             /* wait 16ms or more after power-on       */
     
     /* initial write to lcd is 8bit */
@@ -576,6 +1226,26 @@ void lcd_init(uint8_t dispAttr)
     delay(LCD_DELAY_INIT_REP);                  /* wait 64us                    */
 #endif
 
+#if LCD_GLYPH_CACHE
+    /* CGRAM contents are unknown, the cache starts empty */
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        lcd_glyph_slot[i] = 0;
+        lcd_glyph_lru[i] = i;
+    }
+    lcd_glyph_hit_count = 0;
+    lcd_glyph_miss_count = 0;
+#endif
+
+#if LCD_ASYNC
+    /* TCB1 times the queued instructions from here on, interrupt on compare */
+    TCB1.CTRLA = 0;
+    TCB1.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB1.INTCTRL = TCB_CAPT_bm;
+    lcd_queue_head = lcd_queue_tail = 0;
+    lcd_sending = 0;
+#endif
+
 #if KS0073_4LINES_MODE
     /* Display with KS0073 controller requires special commands for enabling 4 line mode */
 	lcd_command(KS0073_EXTENDED_FUNCTION_REGISTER_ON);
@@ -588,5 +1258,8 @@ void lcd_init(uint8_t dispAttr)
     lcd_clrscr();                           /* display clear                */ 
     lcd_command(LCD_MODE_DEFAULT);          /* set entry mode               */
     lcd_command(dispAttr);                  /* display/cursor control       */
+#if LCD_FRAMEBUFFER
+    lcd_fb_clear();                         /* framebuffer matches display  */
+#endif
 
 }/* lcd_init */
\ No newline at end of file
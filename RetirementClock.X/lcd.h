@@ -28,8 +28,10 @@
  The Hitachi HD44780 controller and its compatible controllers like Samsung KS0066U have become an industry standard for these types of displays. 
  
  This library allows easy interfacing with a HD44780 compatible display and can be
- operated in memory mapped mode (LCD_IO_MODE defined as 0 in the include file lcd.h.) or in 
- 4-bit IO port mode (LCD_IO_MODE defined as 1). 8-bit IO port mode is not supported.
+ operated in memory mapped mode (LCD_IO_MODE defined as 0 in the include file lcd.h.), in 
+ 4-bit IO port mode (LCD_IO_MODE defined as 1) or in 8-bit IO port mode (LCD_IO_MODE defined as 2).
+ With LCD_ASYNC defined as 1 transfers are queued and sent from a timer interrupt.
+ With LCD_WRITE_ONLY defined as 1 the LCD is never read, RW can be tied to GND.
  Memory mapped mode is compatible with old Kanda STK200 starter kit, but also supports
  generation of R/W signal through A8 address line.
  @see The chapter <a href=" http://homepage.hispeed.ch/peterfleury/avr-lcd44780.html" target="_blank">Interfacing a HD44780 Based LCD to an AVR</a>
@@ -105,6 +107,28 @@
 #ifndef LCD_WRAP_LINES
 #define LCD_WRAP_LINES      0     /**< 0: no wrap, 1: wrap at end of visibile line */
 #endif
+#ifndef LCD_FRAMEBUFFER
+#define LCD_FRAMEBUFFER     1     /**< 1: keep a RAM copy of the display for lcd_fb_*() and lcd_flush() */
+#endif
+#ifndef LCD_GLYPH_CACHE
+#define LCD_GLYPH_CACHE     1     /**< 1: lcd_glyph() shares the CGRAM slots between more than 8 custom characters */
+#endif
+#ifndef LCD_HAL_BUS
+#define LCD_HAL_BUS         0     /**< 1: drive the 4-bit bus through hal_lcd_*() in hal.h instead of port pins */
+#endif
+#ifndef LCD_WRITE_ONLY
+#define LCD_WRITE_ONLY      0     /**< 1: hold RW low and wait out execution times instead of reading the busy flag */
+#endif
+#ifndef LCD_ASYNC
+#define LCD_ASYNC  (!LCD_WRITE_ONLY)  /**< 1: queue instructions and data, a TCB1 interrupt sends them in the background */
+#endif
+/* LCD_WRITE_ONLY turns the default LCD_ASYNC off, setting both is an error */
+#if LCD_ASYNC && LCD_WRITE_ONLY
+#error "LCD_ASYNC and LCD_WRITE_ONLY are separate backends, set only one of them"
+#endif
+#ifndef LCD_QUEUE_SIZE
+#define LCD_QUEUE_SIZE     64     /**< entries in the LCD_ASYNC queue, must be a power of two */
+#endif
 
 
 /**
@@ -115,17 +139,30 @@
  * Change LCD_RS_PORT, LCD_RW_PORT, LCD_E_PORT if you want the control lines on
  * different ports. 
  *
- * Normally the four data lines should be mapped to bit 0..3 on one port, but it
- * is possible to connect these data lines in different order or even on different
- * ports by adapting the LCD_DATAx_PORT and LCD_DATAx_PIN definitions.
+ * Normally the four data lines should be mapped to four contiguous bits on one
+ * port (e.g. bit 0..3 or bit 4..7), which lets each nibble be written with a
+ * single port access. It is possible to connect these data lines in different
+ * order or even on different ports by adapting the LCD_DATAx_PORT and 
+ * LCD_DATAx_PIN definitions, at the cost of slower per-pin access.
  *
  * Adjust these definitions to your target.\n 
  * These definitions can be defined in a separate include file \b lcd_definitions.h instead modifying this file by 
  * adding \b -D_LCD_DEFINITIONS_FILE to the \b CDEFS section in the Makefile.
  * All definitions added to the file lcd_definitions.h will override the default definitions from lcd.h
  *  
+ * In 8-bit IO mode (LCD_IO_MODE 2) the data lines D0-D7 are bits 0-7 of 
+ * LCD_DATA_PORT and a byte is one port write and one enable pulse. The
+ * control lines are defined as in 4-bit mode, LCD_DATAx_PORT/PIN are unused.
  */
-#define LCD_IO_MODE      1            /**< 0: memory mapped mode, 1: IO port mode */
+#ifndef LCD_IO_MODE
+#define LCD_IO_MODE      1            /**< 0: memory mapped mode, 1: 4-bit IO port mode, 2: 8-bit IO port mode */
+#endif
+
+#if LCD_IO_MODE == 2
+#ifndef LCD_DATA_PORT
+#define LCD_DATA_PORT    VPORTD       /**< port for 8bit data, D0 on bit 0 */
+#endif
+#endif
 
 #if LCD_IO_MODE
 
@@ -219,6 +256,15 @@
 #ifndef LCD_DELAY_ENABLE_PULSE
 #define LCD_DELAY_ENABLE_PULSE 1      /**< enable signal pulse width in micro seconds */
 #endif
+#ifndef LCD_DELAY_EXEC
+#define LCD_DELAY_EXEC        37      /**< execution time in micro seconds of most instructions */
+#endif
+#ifndef LCD_DELAY_EXEC_DATA
+#define LCD_DELAY_EXEC_DATA   41      /**< execution time in micro seconds of a data write, including the address update */
+#endif
+#ifndef LCD_DELAY_EXEC_CLEAR
+#define LCD_DELAY_EXEC_CLEAR 1520     /**< execution time in micro seconds of clear display and return home */
+#endif
 
 
 /**
@@ -361,11 +407,174 @@ extern void lcd_command(uint8_t cmd);
 extern void lcd_data(uint8_t data);
 
 
+#if LCD_ASYNC
+/**
+ @name  Background transfer
+ With LCD_ASYNC set, lcd_command(), lcd_data() and everything built on them
+ only append to a queue and return. TCB1 times the execution of each
+ instruction and its interrupt sends the next queued byte, so the CPU can 
+ sleep (in IDLE, TCB1 doesn't run in standby) while the display updates.
+ The busy flag is never read; the address counter is tracked in software,
+ assuming the default incrementing entry mode. A call only waits when the
+ queue is full.
+*/
+
+/**
+ @brief    Check whether queued instructions and data are still being sent
+ @return   nonzero until the last queued byte has been executed by the LCD
+*/
+extern uint8_t lcd_busy(void);
+
+
+/**
+ @brief    Wait until all queued instructions and data have been executed
+ 
+ Spins instead of sleeping and works with interrupts disabled. Callers that
+ can sleep should check lcd_busy() from their sleep loop instead.
+ @return   none
+*/
+extern void lcd_wait(void);
+#endif
+
+
+/**
+ @brief    Load a custom character into CGRAM
+ 
+ The character is shown for code and for code+8, which the LCD maps to 
+ the same CGRAM slot. Strings and the framebuffer use LCD_CGRAM_CHAR(),
+ since 0 ends strings and 10 is '\n'. The cursor position is kept.
+ @param    code  character code 0-7
+ @param    glyph 8 rows from the top, bits 4..0 are the dots from left to right
+ @return   none
+*/
+extern void lcd_custom_char(uint8_t code, const uint8_t *glyph);
+
+
+/**
+ @brief    Load a custom character from program memory into CGRAM
+ @param    code  character code 0-7
+ @param    progmem_glyph 8 rows in program memory, see lcd_custom_char()
+ @return   none
+*/
+extern void lcd_custom_char_p(uint8_t code, const uint8_t *progmem_glyph);
+
+/** @brief character code of CGRAM slot n (0-7) that is safe in strings: 8 for slot 0, n otherwise */
+#define LCD_CGRAM_CHAR(n)       ((char)((n) ? (n) : 8))
+
+
+#if LCD_GLYPH_CACHE
+/**
+ @name  Glyph cache
+ lcd_glyph() loads custom characters into CGRAM on demand. A glyph is 
+ identified by its address in program memory. When all 8 slots are taken
+ the least recently used one is reloaded, which also changes the cells
+ still showing the old glyph. Redraw everything that uses custom 
+ characters each frame, using at most 8 different ones per frame, and the
+ next lcd_flush() brings all cells in line. Loading a slot directly with
+ lcd_custom_char() removes it from the cache.
+*/
+
+/**
+ @brief    Get the character code showing a glyph, loading it into CGRAM on a miss
+ @param    progmem_glyph 8 rows in program memory, see lcd_custom_char()
+ @return   LCD_CGRAM_CHAR() of the slot holding the glyph, never a control character the text functions act on
+*/
+extern char lcd_glyph(const uint8_t *progmem_glyph);
+
+
+/**
+ @brief    Number of lcd_glyph() calls that found the glyph in CGRAM
+ @return   hits since lcd_init(), wraps around
+*/
+extern uint16_t lcd_glyph_hits(void);
+
+
+/**
+ @brief    Number of lcd_glyph() calls that had to load the glyph
+ 
+ A miss costs an address command and 8 data writes, and one more command
+ to put the cursor back.
+ @return   misses since lcd_init(), wraps around
+*/
+extern uint16_t lcd_glyph_misses(void);
+#endif
+
+
 /**
  @brief macros for automatically storing string constant in program memory
 */
 #define lcd_puts_P(__s)         lcd_puts_p(PSTR(__s))
 
+
+#if LCD_FRAMEBUFFER
+/**
+ @name  Framebuffer functions
+ The lcd_fb_*() functions only draw into a RAM copy of the display.
+ lcd_flush() compares it with what was last sent to the controller and 
+ transfers just the cells that changed. The contents of the controller are
+ unknown after writing to it with lcd_putc(), lcd_puts() or lcd_data();
+ call lcd_fb_invalidate() before the next lcd_flush() in that case.
+*/
+
+/**
+ @brief    Clear framebuffer and set framebuffer cursor to home position
+ @return   none
+*/
+extern void lcd_fb_clear(void);
+
+
+/**
+ @brief    Set framebuffer cursor to specified position
+ @param    x horizontal position\n (0: left most position)
+ @param    y vertical position\n   (0: first line)
+ @return   none
+*/
+extern void lcd_fb_gotoxy(uint8_t x, uint8_t y);
+
+
+/**
+ @brief    Draw character into framebuffer at cursor position
+ 
+ '\n' moves the cursor to the start of the next line. Characters past the 
+ end of a line are discarded.
+ @param    c character to be drawn
+ @return   none
+*/
+extern void lcd_fb_putc(char c);
+
+
+/**
+ @brief    Draw string into framebuffer
+ @param    s string to be drawn
+ @return   none
+*/
+extern void lcd_fb_puts(const char *s);
+
+
+/**
+ @brief    Draw string from program memory into framebuffer
+ @param    progmem_s string from program memory to be drawn
+ @return   none
+*/
+extern void lcd_fb_puts_p(const char *progmem_s);
+
+
+/**
+ @brief    Transfer changed framebuffer cells to the LCD controller
+ @return   none
+*/
+extern void lcd_flush(void);
+
+
+/**
+ @brief    Forget the known controller contents, next lcd_flush() rewrites all cells
+ @return   none
+*/
+extern void lcd_fb_invalidate(void);
+
+#define lcd_fb_puts_P(__s)      lcd_fb_puts_p(PSTR(__s))
+#endif
+
 /**@}*/
 
 #endif //LCD_H
\ No newline at end of file
@@ -4,10 +4,15 @@
  * Author: Santeri Hiltunen
  * 
  * Runs a 16x2 LCD, an active buzzer and a button.
- * Uses RTC to generate an interrupt every second that changes the 
- * time and date variables displayed on the screen. LCD has 3 modes:
- * clock and date view, retirement date view, and system runtime view.
- * Button changes between the modes. 
+ * Uses the RTC counter to keep time. The RTC only wakes the CPU when the
+ * displayed content changes: every second in the clock and runtime views,
+ * at midnight in the retirement countdown view. The time and date are
+ * caught up from the counter on every wakeup. LCD has 4 modes:
+ * clock and date view, retirement date view, system runtime view, and a
+ * big hh:mm clock over both rows that only wakes once a minute.
+ * Button click changes between the modes, holding it down toggles the
+ * backlight and holding on steps through the modes every half second.
+ * The button is debounced by sampling it with the RTC PIT.
  * Implements accurate time keeping including leap year calculations.
  * 
  * When retirement age is reached, buzzer will sound and a message is displayed.
@@ -21,196 +26,160 @@
  *   GET BIRTHDAY
  *   SET BIRTDAY dd mm yyyy
  *   TGL BACKLIGHT
+ *   GET RXSTATS
+ *   GET GLYPHS
+ *   GET RUNTIME
+ *   GET PROFILE (only when built with PROFILE=1, see profile.h)
  * 
  * 7.12.2020: Basic LCD functionality.
  * 9.12.2020: Complete time keeping.
  * 13.12.2020: Serial interface functionality.
  * 16.12.2020: Optimizations. Retirement alert functional.
+ * 
+ * This file has the hardware setup, the interrupts and the superloop.
+ * The logic is in app.c, which also builds for the host simulator.
  */
 
 #define F_CPU 3333333
-#define MAX_COMMAND_LEN 32 // Max serial command length
-#define RETIREMENT_AGE 65
 
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
+#include <stdint.h>
 #include <avr/io.h>
-#include <avr/sleep.h>
 #include <avr/interrupt.h>
-#include <avr/pgmspace.h>
-#include <util/delay.h>
+#include <util/atomic.h>
+#include "app.h"
+#include "hal.h"
 #include "lcd.h"
 #include "serial.h"
+#include "events.h"
+#include "power.h"
+#include "button.h"
+#include "profile.h"
 
 // Function prototypes
 void RTC_init(void);
-void display_clock(void);
-void display_countdown(void);
-void display_runtime(void);
-static inline void increment_time(void);
-static inline void increment_minute(void);
-static inline void increment_hour(void);
-static inline void increment_day(void);
-static inline void increment_month(void);
-static inline void increment_year(void);
-void retire(void);
-void execute_command(char *command);
-
-// Time keeping variables
-volatile uint16_t year = 2020;
-volatile uint8_t month = 12;
-volatile uint8_t day = 31;
-volatile uint8_t hour = 23;
-volatile uint8_t minute = 59;
-volatile uint8_t second = 55;
-
-// Birthday variables
-volatile uint16_t birth_year = 1965;
-volatile uint8_t birth_month = 12;
-volatile uint8_t birth_day = 31;
-
-// Holds the number of days in each month
-static int days_in_month[] = {31,28,31,30,31,30,31,31,30,31,30,31};
-
-// Keeps track of the system runtime (in seconds)
-volatile uint32_t runtime = 0;
+void rtc_sync(void);
+void rtc_schedule(uint16_t seconds);
 
-// Keeps track of the current lcd mode (3 possible ones)
-volatile uint8_t lcd_mode = 0;
-
-// Holds position of the array index when building command strings
-volatile uint8_t pos = 0;
-
-// Used to hold a padding value for the LCD
-static char padding[2];
+// RTC counter value the clock was last brought up to date at
+static volatile uint16_t rtc_synced;
 
 int main(void)
 {
-    // Initialize the padding array with a 0
-    sprintf(padding, "%d", 0);
+    // Set LCD backlight and buzzer as outputs
+    hal_init();
+    // Set button as input, debounced by the RTC PIT
+    button_init();
     
-    // Set LCD backlight as output
-    PORTB.DIRSET = PIN5_bm;   
-    // Set buzzer as output
-    PORTA.DIRSET = PIN7_bm;
-    // Set button as input
-    PORTF.DIRCLR = PIN6_bm;
-     
-    // Btn triggers an interrupt on falling edge
-    PORTF.PIN6CTRL = PORT_ISC_FALLING_gc; 
+    // USART0 triggers an interrupt on receive complete and, to wake from
+    // standby, on the start of a frame
+    USART0.CTRLA = USART_RXCIE_bm | USART_RXSIE_bm;
     
-    // USART0 triggers an interrupt on receive complete
-    USART0.CTRLA = USART_RXCIE_bm;
+    // Switch off what isn't used. Time is kept by the RTC counter, which
+    // stops in power-down, so sleep no deeper than standby
+    power_init();
+    power_set_deepest(SLPCTRL_SMODE_STDBY_gc);
+    // Start the cycle counter when built with PROFILE=1
+    profile_init();
     
-    // Set sleep mode
-    set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
-    
-    // Initialize LCD
+    // Initialize LCD. Also clears the display and the framebuffer
     lcd_init(LCD_DISP_ON);
-    // Clear LCD
-    lcd_clrscr();
     // Turn on LCD backlight
-    PORTB.OUTSET = PIN5_bm;
+    hal_backlight(1);
     
     //Initialize USART0
     USART0_init();
     
+    // Start the clock and work out when to retire
+    app_init();
+    
     // Initialize RTC
     RTC_init();
            
     // Enable interrupts
     sei();
 
-    // Superloop enters sleep mode
+    // Superloop sleeps until an ISR posts an event, then handles it
     while(1)
     {
-        sleep_mode();
+        uint8_t events = events_wait();
+        
+        // Catch the clock up with the RTC counter before using it
+        rtc_sync();
+        // Handle received serial commands. They may change what is shown
+        if ((events & EVENT_SERIAL) && serial_task())
+        {
+            events |= EVENT_TICK;
+        }
+        // Change the LCD view, keeps stepping while held after a long press
+        if (events & (EVENT_BUTTON_CLICK | EVENT_BUTTON_REPEAT))
+        {
+            app_next_view();
+        }
+        // Holding the button down toggles the backlight
+        if (events & EVENT_BUTTON_LONG)
+        {
+            hal_backlight_toggle();
+        }
+        // Redraw when time passed, the view changed or a command was run
+        if (events & (EVENT_TICK | EVENT_BUTTON_CLICK | EVENT_BUTTON_REPEAT))
+        {
+            render();
+            // Sleep until the display content changes next
+            rtc_schedule(next_wakeup());
+        }
     }
 }
 
-// Triggered when a byte is received through USART0 (serial console input)
-ISR(USART0_RXC_vect)
+// Triggered by RTC when the counter reaches the scheduled wakeup
+ISR(RTC_CNT_vect)
 {
+    PROFILE_ENTER(PROF_ISR_RTC_CNT);
     // Clear the interrupt flag
-    USART0.RXDATAH = USART_RXCIF_bm;
-    
-    char command[MAX_COMMAND_LEN];
-   
-    char c;
-    c = USART0_readChar();
-    
-    // Build the command array
-    if((c != '\n') && (c != '\r'))
-    {
-        command[pos++] = c;
-        if(pos > MAX_COMMAND_LEN)
-        {
-            pos = 0;
-        }
-    }
-    // PuTTY console ends lines with '\r' when enter is pressed
-    if(c == '\r')
-    {          
-        command[pos] = '\0';
-        pos = 0;
-        execute_command(command);
-    }
+    RTC.INTFLAGS = RTC_CMP_bm;
+    // Display is updated in the superloop
+    event_post(EVENT_TICK);
+    PROFILE_EXIT(PROF_ISR_RTC_CNT);
 }
 
-// Triggered on a button press
-ISR(PORTF_PORT_vect)
+/*
+ * Advances the time, date and runtime by the seconds the RTC counter has
+ * counted since the last call.
+ */
+void rtc_sync(void)
 {
-    // Clear the interrupt flag
-    PORTF.INTFLAGS = PORTF.INTFLAGS;
-    // Change the LCD view
-    lcd_mode = ((lcd_mode + 1) % 3);
-    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint16_t elapsed = RTC.CNT - rtc_synced;
+        
+        rtc_synced += elapsed;
+        app_advance(elapsed);
+    }
 }
 
-// Triggered by RTC once a second
-ISR(RTC_PIT_vect)
+/*
+ * Programs the RTC compare to wake the CPU the given number of seconds
+ * after the last synced second.
+ */
+void rtc_schedule(uint16_t seconds)
 {
-    // Clear the interrupt flag
-    RTC.PITINTFLAGS = RTC_PI_bm;
-    // Increment the system runtime
-    runtime++;
-    // Increment the time and date variables
-    increment_time();
-    
-    // Check if it's time to retire. Exit the ISR if it is
-    if (year >= (birth_year + RETIREMENT_AGE))
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-        if (year > (birth_year + RETIREMENT_AGE))
+        uint16_t now = RTC.CNT;
+        uint16_t wakeup = rtc_synced + seconds;
+        
+        // Wake on the next count if that moment has already passed
+        if ((uint16_t)(wakeup - now - 1) >= seconds)
         {
-            retire();
-            return;
+            wakeup = now + 1;
         }
-        else if (month >= birth_month)
+        while (RTC.STATUS & RTC_CMPBUSY_bm)
         {
-            if (day >= birth_day)
-            {
-                retire();
-                return;
-            }
+            ; /* Wait for the previous compare value to be synchronized */
         }
+        RTC.CMP = wakeup;
     }
-    // Turn buzzer off
-    PORTA.OUTCLR = PIN7_bm;
-    // Enter the appropriate time showing function
-    switch (lcd_mode)
-    {
-        case 0:
-            display_clock();
-            break;
-        case 1:
-            display_countdown();
-            break;
-        case 2:
-            display_runtime();
-            break;       
-    }    
 }
+
 // RTC initialization. Example code from Microchip's repo
 void RTC_init(void)
 {
@@ -253,308 +222,19 @@ void RTC_init(void)
     /* Run in debug: enabled */
     RTC.DBGCTRL = RTC_DBGRUN_bm;
 
-    RTC.PITINTCTRL = RTC_PI_bm; /* Periodic Interrupt: enabled */
+    /* Count seconds over the full 16-bit range, first wakeup after 1 s */
+    RTC.PER = 0xFFFF;
+    RTC.CNT = 0;
+    RTC.CMP = 1;
+    rtc_synced = 0;
 
-    RTC.PITCTRLA = RTC_PERIOD_CYC32768_gc /* RTC Clock Cycles 32768 */
-        | RTC_PITEN_bm; /* Enable: enabled */
-}
+    RTC.INTCTRL = RTC_CMP_bm; /* Compare Interrupt: enabled */
 
-// Displays a time and date view
-void display_clock(void)
-{
-    // Holds time and date variables
-    char buffer[16];
-    
-    // Clear LCD
-    lcd_clrscr();
-    // Pad with a 0 if the value has only a single digit
-    if (hour < 10)
-    {
-        lcd_puts(padding);
-    }
-    // Display hours on top row
-    sprintf(buffer, "%d:", hour); 
-    lcd_puts(buffer);
-    
-    if (minute < 10)
-    {
-        lcd_puts(padding);
-    }
-    // Display minutes on top row
-    sprintf(buffer, "%d:", minute);
-    lcd_puts(buffer);
-    
-    if (second < 10)
-    {
-        lcd_puts(padding);
-    }    
-    // Display seconds on top row. Move cursor to next row
-    sprintf(buffer, "%d\n", second);
-    lcd_puts(buffer);
-    
-    // Display date on bottom row
-    sprintf(buffer, "%d.%d.%d", day, month, year);
-    lcd_puts(buffer);
-}
-
-// Displays retirement date. TODO: countdown to retirement
-void display_countdown(void)
-{
-    // Holds time and date variables
-    char buffer[16];
-    // Clear LCD
-    lcd_clrscr();
-    sprintf(buffer, "%d.%d.%d",
-            birth_day, birth_month, birth_year + RETIREMENT_AGE);
-    lcd_puts(buffer);
-    lcd_puts("\nRetirement date");
-}
-
-// Display how long the system has been running
-void display_runtime(void)
-{
-    // Holds time and date variables
-    char buffer[8];
-    // Placeholder for conversions
-    uint32_t num = runtime;
-    
-    // Clear LCD
-    lcd_clrscr();
-    
-    // Calculate and display days. (86400 seconds in a day)
-    sprintf(buffer, "%d:", (int)floor(num / 86400));
-    lcd_puts(buffer); 
-    
-    // Calculate and display hours
-    num = num % 86400;
-    sprintf(buffer, "%d:", (int)floor(num / 3600));
-    lcd_puts(buffer);
-    
-    // Calculate and display minutes
-    num %= 3600;
-    sprintf(buffer, "%d:", (int)floor(num / 60));
-    lcd_puts(buffer);
-
-    // Calculate and display seconds
-    num %= 60;
-    sprintf(buffer, "%d", (int)floor(num));
-    lcd_puts(buffer);
-    lcd_puts("\nSystem runtime");
-}
-
-/* Time and date incrementation functions.
- * As the seconds are about to "overflow" to 60,
- * they are reset to 0 and increment_minute() is called. 
- * This method is repeated up to year increments
- */
-static inline void increment_time(void)
-{
-    if (second == 59)
-    {
-        second = 0;
-        increment_minute();
-    }
-    else
-    {
-        second++;
-    }
-}
-
-static inline void increment_minute(void)
-{
-    if (minute == 59)
-    {
-        minute = 0;
-        increment_hour();
-    }
-    else
-    {
-        minute++;
-    }
-}
-
-static inline void increment_hour(void)
-{
-    if (hour == 23)
-    {
-        hour = 0;
-        increment_day();
-    }
-    else
-    {
-        hour++;
-    }
-}
-
-static inline void increment_day(void)
-{
-    // Check if it's the last day of the month. > handles February 29th
-    if (day >= (days_in_month[month - 1]))
-    {
-        // If it's leap year and it's February 28th, increment date to 29
-        if ((((month == 2) && (day == 28)) && ((((year % 400) == 0)
-                || ((year % 100) != 0)) && ((year % 4) == 0))))
-        {
-            day++;
-        }
-        else
-        {
-            day = 1;
-            increment_month();
-        }
-
-    }
-    else
-    {
-        day++;
-    } 
-}
-
-static inline void increment_month(void)
-{
-    if (month == 12)
-    {
-        month = 1;
-        increment_year();
-    }
-    else
-    {
-        month++;
-    }
-}
-
-static inline void increment_year(void)
-{
-    year++;
-}
-
-void retire(void)
-{
-    lcd_clrscr();
-    
-    lcd_gotoxy(4,0);
-    lcd_puts("Go home,");
-    
-    lcd_gotoxy(3,1);
-    lcd_puts("old timer!");
-    PORTA.OUTSET = PIN7_bm;
-}
-
-// Execute serial terminal commands
-void execute_command(char *command)
-{
-    /*
-     * Set date and time. Compare first 12 symbols of the command.
-     * Syntax is "SET DATETIME dd mm yyyy hh mm ss".
-     * Incorrect syntax will print garbage values to LCD.
-     */
-    if (strncmp(command, "SET DATETIME", 12) == 0)
-    {
-        char delim[] = " ";
-        char *saveptr;
-        char *ptr = strtok_r(command, delim, &saveptr);
-        
-        uint8_t count = 0;
-        
-        while(ptr != NULL)
-        {
-            /*
-             * Values of the split words are saved as integers.
-             * First 2 words (SET and DATETIME) are saved but overwritten
-             * and never used.
-             */
-            uint16_t num;
-            sscanf(ptr, "%d", &num);
-            
-            // Set values from 3rd word onwards (time and date values)
-            switch (count)
-            {
-                case 2:
-                    day = num;
-                    break;
-                case 3:
-                    month = num;
-                    break;
-                case 4:
-                    year = num;
-                    break;
-                case 5:
-                    hour = num;
-                    break;
-                case 6:
-                    minute = num;
-                    break;
-                case 7:
-                    second = num;
-                    break;
-            }
-            // Move onto next case
-            count++;
-            // Save next token to ptr
-            ptr = strtok_r(NULL, delim, &saveptr);
-        }
-    }
-    // Print date and time in the serial console
-    else if (strcmp(command, "GET DATETIME") == 0)
-    {
-        char buffer[33];
-        sprintf(buffer, "%d.%d.%d %d:%d:%d\r\n",
-                day,month,year,hour,minute,second);
-        
-        USART0_sendString(buffer);
-    }
-    /*
-     * Set birthday. Compare first 12 symbols of the command.
-     * Syntax is "SET BIRTHDAY dd mm yyyy".
-     * Incorrect syntax will print garbage values to LCD.
-     * Works identically to the SET DATETIME -command with fewer arguments
-     */    
-    else if(strncmp(command, "SET BIRTHDAY", 12) == 0)
-    {
-        char delim[] = " ";
-        char *saveptr;
-        char *ptr = strtok_r(command, delim, &saveptr);
-        
-        uint8_t count = 0;
-        
-        while(ptr != NULL)
-        {
-            uint16_t num;
-            sscanf(ptr, "%d", &num);
-            
-            switch (count)
-            {
-                case 2:
-                    birth_day = num;
-                    break;
-                case 3:
-                    birth_month = num;
-                    break;
-                case 4:
-                    birth_year = num;
-                    break;
-            }
-            count++;
-            ptr = strtok_r(NULL, delim, &saveptr);
-        }
-    }
-    // Print birthday to the serial console
-    else if (strcmp(command, "GET BIRTHDAY") == 0)
-    {
-        char buffer[33];
-        sprintf(buffer, "%d.%d.%d\r\n",
-                birth_day, birth_month, birth_year);
-        
-        USART0_sendString(buffer);
-    }    
-    // Toggle the LED backlight bits
-    else if (strcmp(command, "TGL BACKLIGHT") == 0)
-    {
-        PORTB.OUTTGL = PIN5_bm;
-        USART0_sendString("BACKLIGHT TOGGLED.\r\n");
-    }
-    else 
+    while (RTC.STATUS > 0)
     {
-        USART0_sendString("Incorrect command.\r\n");
+        ; /* Wait for all register to be synchronized */
     }
+    RTC.CTRLA = RTC_PRESCALER_DIV32768_gc /* 1 count per second */
+        | RTC_RTCEN_bm /* Enable: enabled */
+        | RTC_RUNSTDBY_bm; /* Run In Standby: enabled */
 }
@@ -0,0 +1,95 @@
+/* 
+ * File: power.c
+ * Sleep mode selection and power gating of unused hardware
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include "power.h"
+#include "serial.h"
+#include "lcd.h"
+
+/*
+ * Pins connected to something on the board. Input buffers of all other pins
+ * are disabled so floating inputs don't draw current.
+ *   PORTA: PA0 USART TX, PA1 USART RX, PA7 buzzer
+ *   PORTB: PB3 LCD E, PB4 LCD RS, PB5 LCD backlight
+ *   PORTC: PC3 LCD RW
+ *   PORTD: PD4-PD7 LCD data, PD0-PD7 with the 8-bit LCD bus
+ *   PORTF: PF0-PF1 32.768 kHz crystal, PF6 button
+ */
+#define PORTA_USED (PIN0_bm | PIN1_bm | PIN7_bm)
+#define PORTB_USED (PIN3_bm | PIN4_bm | PIN5_bm)
+#define PORTC_USED (PIN3_bm)
+#if LCD_IO_MODE == 2
+#define PORTD_USED (0xFF)
+#else
+#define PORTD_USED (PIN4_bm | PIN5_bm | PIN6_bm | PIN7_bm)
+#endif
+#define PORTE_USED (0)
+#define PORTF_USED (PIN0_bm | PIN1_bm | PIN6_bm)
+
+static void disable_unused_pins(PORT_t *port, uint8_t used);
+
+// Deepest sleep mode allowed by the application
+static uint8_t deepest_mode = SLPCTRL_SMODE_PDOWN_gc;
+
+static void disable_unused_pins(PORT_t *port, uint8_t used)
+{
+    register8_t *pinctrl = &port->PIN0CTRL;
+    
+    for (uint8_t pin = 0; pin < 8; pin++)
+    {
+        if (!(used & (1 << pin)))
+        {
+            pinctrl[pin] = PORT_ISC_INPUT_DISABLE_gc;
+        }
+    }
+}
+
+void power_init(void)
+{
+    disable_unused_pins(&PORTA, PORTA_USED);
+    disable_unused_pins(&PORTB, PORTB_USED);
+    disable_unused_pins(&PORTC, PORTC_USED);
+    disable_unused_pins(&PORTD, PORTD_USED);
+    disable_unused_pins(&PORTE, PORTE_USED);
+    disable_unused_pins(&PORTF, PORTF_USED);
+    
+    // Analog peripherals are not used. Make sure they stay off
+    ADC0.CTRLA = 0;
+    AC0.CTRLA = 0;
+}
+
+void power_set_deepest(uint8_t mode)
+{
+    deepest_mode = mode;
+}
+
+uint8_t power_sleep_mode(void)
+{
+    // USART transmitter stops without the peripheral clock
+    if (USART0_txBusy())
+    {
+        return SLPCTRL_SMODE_IDLE_gc;
+    }
+#if LCD_ASYNC
+    // TCB1 times the LCD transfer and stops in standby
+    if (lcd_busy())
+    {
+        return SLPCTRL_SMODE_IDLE_gc;
+    }
+#endif
+    return deepest_mode;
+}
+
+void power_sleep(void)
+{
+    set_sleep_mode(power_sleep_mode());
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
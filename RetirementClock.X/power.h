@@ -0,0 +1,32 @@
+/* 
+ * File: power.h
+ * Sleep mode selection and power gating of unused hardware.
+ * 
+ * power_sleep() puts the CPU in the deepest sleep mode that doesn't stop
+ * anything still in progress:
+ *   IDLE        a USART transmission or a queued LCD transfer is in
+ *               flight (needs the peripheral clock)
+ *   STANDBY     the RTC counter, USART start-of-frame detection and
+ *               pin interrupts keep running
+ *   POWER-DOWN  only pin interrupts and the RTC PIT keep running
+ * The deepest mode can be limited with power_set_deepest().
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// Disable unused peripherals and the input buffers of unconnected pins
+void power_init(void);
+// Limit sleep to a mode no deeper than SLPCTRL_SMODE_xxx_gc
+void power_set_deepest(uint8_t mode);
+// Sleep mode power_sleep() would use right now
+uint8_t power_sleep_mode(void);
+/*
+ * Sleep until an interrupt. Must be called with interrupts disabled, they
+ * are enabled just before sleeping so a pending interrupt still wakes it.
+ */
+void power_sleep(void);
+
+#endif // POWER_H
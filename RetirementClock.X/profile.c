@@ -0,0 +1,92 @@
+/* 
+ * File: profile.c
+ * On-target profiling with TCB0, see profile.h.
+ */
+
+#include "profile.h"
+
+#if PROFILE
+
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "serial.h"
+#include "format.h"
+
+profile_entry_t profile_table[PROF_COUNT];
+
+// Region names for the dump, in PROF_xxx order
+static const char profile_names[PROF_COUNT][18] PROGMEM =
+{
+    "ISR RTC_CNT",
+    "ISR RTC_PIT",
+    "ISR PORTF",
+    "ISR USART0_RXC",
+    "ISR USART0_DRE",
+    "display_clock",
+    "display_countdown",
+    "display_runtime",
+    "lcd_waitbusy",
+    "execute_command",
+    "ISR TCB1",
+    "display_bigclock",
+};
+
+void profile_init(void)
+{
+    for (uint8_t i = 0; i < PROF_COUNT; i++)
+    {
+        profile_table[i].count = 0;
+        profile_table[i].min = 0xFFFF;
+        profile_table[i].max = 0;
+        profile_table[i].total = 0;
+    }
+    
+    // Free running over the full 16 bits at the CPU clock, no interrupts
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.CCMP = 0xFFFF;
+    TCB0.CNT = 0;
+    TCB0.INTCTRL = 0;
+    TCB0.CTRLA = TCB_CLKSEL_CLKDIV1_gc | TCB_ENABLE_bm;
+}
+
+/*
+ * One line per measured region: name, count, then min/avg/max cycles.
+ * Regions that never ran are left out.
+ */
+void profile_dump(void)
+{
+    char buffer[18];
+    
+    for (uint8_t i = 0; i < PROF_COUNT; i++)
+    {
+        profile_entry_t entry;
+        
+        // ISRs may update their entries while this one is copied
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            entry = profile_table[i];
+        }
+        if (!entry.count)
+        {
+            continue;
+        }
+        
+        memcpy_P(buffer, profile_names[i], sizeof(buffer));
+        USART0_sendString(buffer);
+        USART0_sendString(": N=");
+        *fmt_u32(buffer, entry.count) = '\0';
+        USART0_sendString(buffer);
+        USART0_sendString(" MIN=");
+        *fmt_u32(buffer, entry.min) = '\0';
+        USART0_sendString(buffer);
+        USART0_sendString(" AVG=");
+        *fmt_u32(buffer, entry.total / entry.count) = '\0';
+        USART0_sendString(buffer);
+        USART0_sendString(" MAX=");
+        *fmt_u32(buffer, entry.max) = '\0';
+        USART0_sendString(buffer);
+        USART0_sendString("\r\n");
+    }
+}
+
+#endif // PROFILE
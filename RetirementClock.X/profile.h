@@ -0,0 +1,89 @@
+/* 
+ * File: profile.h
+ * On-target profiling of hot regions with TCB0 as a cycle counter.
+ * 
+ * TCB0 counts CLK_PER freely, so a tick is one CPU cycle and a region can
+ * be up to 65535 cycles (~19.7 ms) long. A region is measured by wrapping
+ * it in PROFILE_ENTER(id) ... PROFILE_EXIT(id) in the same block. Entering
+ * is a single 16-bit counter read, exiting updates the count, minimum,
+ * maximum and total of that id. Times are inclusive: interrupts taken
+ * inside a main context region are part of it.
+ * 
+ * Built with PROFILE=1 only. Otherwise the macros are empty, the table and
+ * TCB0 are left alone and GET PROFILE doesn't exist.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+// Profiled regions
+#define PROF_ISR_RTC_CNT        0
+#define PROF_ISR_RTC_PIT        1
+#define PROF_ISR_PORTF          2
+#define PROF_ISR_USART0_RXC     3
+#define PROF_ISR_USART0_DRE     4
+#define PROF_DISPLAY_CLOCK      5
+#define PROF_DISPLAY_COUNTDOWN  6
+#define PROF_DISPLAY_RUNTIME    7
+#define PROF_LCD_WAITBUSY       8
+#define PROF_EXECUTE_COMMAND    9
+#define PROF_ISR_TCB1           10
+#define PROF_DISPLAY_BIGCLOCK   11
+#define PROF_COUNT              12
+
+#if PROFILE
+
+#include <avr/io.h>
+
+typedef struct
+{
+    uint16_t count;     // Times measured, stops at 0xFFFF
+    uint16_t min;       // Cycles
+    uint16_t max;
+    uint32_t total;
+} profile_entry_t;
+
+extern profile_entry_t profile_table[PROF_COUNT];
+
+// Start TCB0 counting and clear the table
+void profile_init(void);
+// Print the table to the serial console
+void profile_dump(void);
+
+static inline void profile_record(uint8_t id, uint16_t cycles)
+{
+    profile_entry_t *entry = &profile_table[id];
+    
+    if (entry->count != 0xFFFF)
+    {
+        entry->count++;
+        entry->total += cycles;
+    }
+    if (cycles < entry->min)
+    {
+        entry->min = cycles;
+    }
+    if (cycles > entry->max)
+    {
+        entry->max = cycles;
+    }
+}
+
+#define PROFILE_ENTER(id)   uint16_t profile_start_##id = TCB0.CNT
+#define PROFILE_EXIT(id)    profile_record((id), TCB0.CNT - profile_start_##id)
+
+#else
+
+#define profile_init()
+#define PROFILE_ENTER(id)
+#define PROFILE_EXIT(id)
+
+#endif // PROFILE
+
+#endif // PROFILE_H
@@ -22,10 +22,42 @@
 
 #define F_CPU 3333333
 #define USART0_BAUD_RATE(BAUD_RATE) ((float)(F_CPU * 64 / (16 * (float)BAUD_RATE)) + 0.5)
+#define USART0_TX_BUFFER_SIZE 64 // Must be a power of two
+#define USART0_TX_BUFFER_MASK (USART0_TX_BUFFER_SIZE - 1)
+#define USART0_RX_BUFFER_SIZE 64 // Must be a power of two
+#define USART0_RX_BUFFER_MASK (USART0_RX_BUFFER_SIZE - 1)
 
 #include <avr/io.h>
-#include <stdio.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <string.h>
+#include "serial.h"
+#include "events.h"
+#include "profile.h"
+
+/*
+ * Transmit ring buffer. Bytes are queued at tx_head by the main program and
+ * taken from tx_tail by the data register empty interrupt, so each index
+ * has a single writer.
+ */
+static volatile char tx_buffer[USART0_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+// Set once a byte has been loaded into the transmitter since the last flush
+static volatile uint8_t tx_loaded = 0;
+
+/*
+ * Receive ring buffer. Filled at rx_head by the receive complete interrupt
+ * and emptied at rx_tail by the main program.
+ */
+static volatile char rx_buffer[USART0_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+// Received bytes lost to a full buffer or a hardware receiver overrun
+static volatile uint16_t rx_dropped = 0;
+
+static void USART0_txNext(void);
+static inline void USART0_rxNext(void);
 
 void USART0_init(void)
 {
@@ -34,33 +66,182 @@ void USART0_init(void)
     
     USART0.BAUD = (uint16_t)USART0_BAUD_RATE(9600);
 
-    USART0.CTRLB |= USART_RXEN_bm | USART_TXEN_bm;
+    // Start-of-frame detection wakes the receiver from standby sleep
+    USART0.CTRLB |= USART_RXEN_bm | USART_TXEN_bm | USART_SFDEN_bm;
+    
     
+}
+
+// Move the next queued byte to the transmitter, or stop when none are left
+static void USART0_txNext(void)
+{
+    uint8_t tail = tx_tail;
     
+    if (tail == tx_head)
+    {
+        USART0.CTRLA &= ~USART_DREIE_bm;
+        return;
+    }
+    // Writing TXCIF clears it, so it is only set again after this byte
+    USART0.STATUS = USART_TXCIF_bm;
+    USART0.TXDATAL = tx_buffer[tail];
+    tx_tail = (tail + 1) & USART0_TX_BUFFER_MASK;
+    tx_loaded = 1;
+}
+
+// Triggered when the transmitter can take another byte
+ISR(USART0_DRE_vect)
+{
+    PROFILE_ENTER(PROF_ISR_USART0_DRE);
+    USART0_txNext();
+    PROFILE_EXIT(PROF_ISR_USART0_DRE);
+}
+
+uint8_t USART0_write(const char *data, uint8_t len)
+{
+    uint8_t head = tx_head;
+    uint8_t count = 0;
+    
+    // One slot is kept empty to tell a full buffer from an empty one
+    while ((count < len) 
+            && (((head + 1) & USART0_TX_BUFFER_MASK) != tx_tail))
+    {
+        tx_buffer[head] = data[count++];
+        head = (head + 1) & USART0_TX_BUFFER_MASK;
+    }
+    tx_head = head;
+    
+    if (count)
+    {
+        USART0.CTRLA |= USART_DREIE_bm;
+    }
+    return count;
 }
 
 void USART0_sendChar(char c)
 {
-    while (!(USART0.STATUS & USART_DREIF_bm))
+    while (!USART0_write(&c, 1))
+    {
+        /*
+         * Buffer is full. With interrupts disabled (e.g. when called from an
+         * ISR) the DRE interrupt can't run, so move bytes out by polling.
+         */
+        if (!(SREG & CPU_I_bm) && (USART0.STATUS & USART_DREIF_bm))
+        {
+            USART0_txNext();
+        }
+    }
+}
+
+void USART0_sendString(const char *str)
+{
+    while (*str)
+    {
+        USART0_sendChar(*str++);
+    }
+}
+
+void USART0_flush(void)
+{
+    // Wait until the buffer is empty...
+    while (tx_head != tx_tail)
+    {
+        if (!(SREG & CPU_I_bm) && (USART0.STATUS & USART_DREIF_bm))
+        {
+            USART0_txNext();
+        }
+    }
+    // ...and the last byte has left the shift register
+    if (tx_loaded)
     {
-        ;    
+        while (!(USART0.STATUS & USART_TXCIF_bm))
+        {
+            ;
+        }
+        tx_loaded = 0;
     }
-    USART0.TXDATAL = c;
 }
 
-void USART0_sendString(char *str)
+// Triggered when a byte is received or a start bit woke us from standby
+ISR(USART0_RXC_vect)
 {
-    for(size_t i = 0; i < strlen(str); i++)
+    PROFILE_ENTER(PROF_ISR_USART0_RXC);
+    USART0_rxNext();
+    PROFILE_EXIT(PROF_ISR_USART0_RXC);
+}
+
+// Store a received byte, or just acknowledge the start of a frame
+static inline void USART0_rxNext(void)
+{
+    // Start of a frame, the byte itself arrives in a later interrupt
+    if (USART0.STATUS & USART_RXSIF_bm)
+    {
+        USART0.STATUS = USART_RXSIF_bm;
+        if (!(USART0.STATUS & USART_RXCIF_bm))
+        {
+            return;
+        }
+    }
+    
+    // RXDATAH must be read first, reading RXDATAL clears the flags
+    uint8_t status = USART0.RXDATAH;
+    char c = USART0.RXDATAL;
+    uint8_t next = (rx_head + 1) & USART0_RX_BUFFER_MASK;
+    
+    // At least one byte was lost before this one
+    if (status & USART_BUFOVF_bm)
+    {
+        rx_dropped++;
+    }
+    if (next == rx_tail)
+    {
+        rx_dropped++;
+    }
+    else
     {
-        USART0_sendChar(str[i]);
+        rx_buffer[rx_head] = c;
+        rx_head = next;
     }
+    event_post(EVENT_SERIAL);
+}
+
+uint8_t USART0_read(char *c)
+{
+    uint8_t tail = rx_tail;
+    
+    if (tail == rx_head)
+    {
+        return 0;
+    }
+    *c = rx_buffer[tail];
+    rx_tail = (tail + 1) & USART0_RX_BUFFER_MASK;
+    return 1;
+}
+
+uint8_t USART0_txBusy(void)
+{
+    return (tx_head != tx_tail)
+            || (tx_loaded && !(USART0.STATUS & USART_TXCIF_bm));
 }
 
 char USART0_readChar(void)
 {
-    while (!(USART0.STATUS & USART_RXCIF_bm))
+    char c;
+    
+    while (!USART0_read(&c))
     {
         ;
     }
-    return USART0.RXDATAL;
+    return c;
+}
+
+uint16_t USART0_rxDropped(void)
+{
+    uint16_t dropped;
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dropped = rx_dropped;
+    }
+    return dropped;
 }
\ No newline at end of file
@@ -3,7 +3,27 @@
  * Header file for serial.c functions
  */
 
+#include <stdint.h>
+
 void USART0_init(void);
+/*
+ * Queue up to len bytes for transmission without waiting.
+ * Returns the number of bytes queued, less than len if the buffer is full.
+ */
+uint8_t USART0_write(const char *data, uint8_t len);
+// Queue a byte/string, waiting for buffer space if needed
 void USART0_sendChar(char c);
-void USART0_sendString(char *str);
-char USART0_readChar(void);
\ No newline at end of file
+void USART0_sendString(const char *str);
+// Wait until all queued bytes have been transmitted
+void USART0_flush(void);
+// Returns 1 while queued bytes are still being transmitted
+uint8_t USART0_txBusy(void);
+/*
+ * Take one received byte from the buffer without waiting.
+ * Returns 1 and stores the byte in c, or 0 if nothing has been received.
+ */
+uint8_t USART0_read(char *c);
+// Wait for and return the next received byte
+char USART0_readChar(void);
+// Number of received bytes lost because the program didn't keep up
+uint16_t USART0_rxDropped(void);
\ No newline at end of file
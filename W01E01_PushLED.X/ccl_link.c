@@ -0,0 +1,95 @@
+/* 
+ * File: ccl_link.c
+ * Button to LED link in hardware using the Event System and CCL,
+ * see ccl_link.h.
+ */
+
+#include <avr/io.h>
+#include "ccl_link.h"
+
+/*
+ * LUT3 truth tables, indexed by IN2:IN1:IN0. IN0 is the button, low when
+ * pressed, IN2 is masked to 0.
+ *   Button only: IN1 masked, output high at index 0
+ *   With PWM:    output high at index 2, button pressed and WO1 high
+ */
+#define TRUTH_BUTTON    0x01
+#define TRUTH_PWM       0x04
+// Input combinations the LUT can actually see, for inverting
+#define TRUTH_USED_BUTTON   0x03
+#define TRUTH_USED_PWM      0x0F
+
+// Set while TCA0 runs for the link
+static uint8_t pwm_used;
+
+static void pwm_start(void);
+
+// Single slope PWM on TCA0 WO1 for LUT3 input 1
+static void pwm_start(void)
+{
+    TCA0.SINGLE.CTRLA = 0;
+    TCA0.SINGLE.CTRLB = TCA_SINGLE_CMP1EN_bm | TCA_SINGLE_WGMODE_SINGLESLOPE_gc;
+    TCA0.SINGLE.PER = CCL_LINK_PWM_PER;
+    TCA0.SINGLE.CMP1 = CCL_LINK_PWM_DUTY;
+    TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+    pwm_used = 1;
+}
+
+void ccl_link_init(uint8_t options)
+{
+    uint8_t truth;
+    uint8_t used;
+    
+    // Set button as input and LUT3 output pin as output
+    PORTF.DIRCLR = PIN6_bm;
+    PORTF.DIRSET = PIN3_bm;
+    
+    // Button is the event generator, LUT3 input A the user
+    EVSYS.CHANNEL4 = EVSYS_GENERATOR_PORT1_PIN6_gc;
+    EVSYS.USERCCLLUT3A = EVSYS_CHANNEL_CHANNEL4_gc;
+    
+    // LUTs can only be configured while the CCL is disabled
+    CCL.CTRLA = 0;
+    
+    if (options & CCL_LINK_PWM)
+    {
+        pwm_start();
+        CCL.LUT3CTRLB = CCL_INSEL0_EVENTA_gc | CCL_INSEL1_TCA0_gc;
+        truth = TRUTH_PWM;
+        used = TRUTH_USED_PWM;
+    }
+    else
+    {
+        CCL.LUT3CTRLB = CCL_INSEL0_EVENTA_gc | CCL_INSEL1_MASK_gc;
+        truth = TRUTH_BUTTON;
+        used = TRUTH_USED_BUTTON;
+    }
+    CCL.LUT3CTRLC = CCL_INSEL2_MASK_gc;
+    
+    if (options & CCL_LINK_ACTIVE_LOW)
+    {
+        truth = ~truth & used;
+    }
+    CCL.TRUTH3 = truth;
+    
+    // Output on the default pin PF3, no filter so no clock is needed
+    PORTMUX.CCLROUTEA &= ~PORTMUX_LUT3_bm;
+    CCL.LUT3CTRLA = CCL_OUTEN_bm | CCL_ENABLE_bm;
+    CCL.CTRLA = CCL_RUNSTDBY_bm | CCL_ENABLE_bm;
+}
+
+void ccl_link_disable(void)
+{
+    CCL.CTRLA = 0;
+    CCL.LUT3CTRLA = 0;
+    EVSYS.USERCCLLUT3A = 0;
+    EVSYS.CHANNEL4 = 0;
+    PORTF.DIRCLR = PIN3_bm;
+    
+    if (pwm_used)
+    {
+        TCA0.SINGLE.CTRLA = 0;
+        TCA0.SINGLE.CTRLB = 0;
+        pwm_used = 0;
+    }
+}
@@ -0,0 +1,41 @@
+/* 
+ * File: ccl_link.h
+ * Button to LED link in hardware using the Event System and CCL.
+ * 
+ * The PF6 button is an event generator on EVSYS channel 4, which feeds
+ * input 0 of CCL LUT3. LUT3 drives its output pin PF3 with no CPU
+ * involvement, so the response doesn't depend on the CPU being awake.
+ * Optionally LUT3 input 1 takes TCA0 WO1 to dim the LED with PWM, and
+ * ccl_link_init() starts TCA0 for it.
+ * 
+ * Neither CCL nor EVSYS outputs can reach PF5, so the linked LED is an
+ * external one on PF3 (to GND through a resistor, or to VCC with
+ * CCL_LINK_ACTIVE_LOW). The LUT has no filter or edge detector and needs
+ * no clock, so the link keeps working in power-down. With CCL_LINK_PWM
+ * TCA0 must run, which only happens in IDLE. TCA0 is then taken over
+ * for the PWM, its WO1 pin PA1 is left an input.
+ */
+
+#ifndef CCL_LINK_H
+#define CCL_LINK_H
+
+#include <stdint.h>
+
+// TCA0 period and WO1 on time for CCL_LINK_PWM, ~13 kHz at 1/8 duty
+#ifndef CCL_LINK_PWM_PER
+#define CCL_LINK_PWM_PER    0xFF
+#endif
+#ifndef CCL_LINK_PWM_DUTY
+#define CCL_LINK_PWM_DUTY   0x20
+#endif
+
+// Options for ccl_link_init()
+#define CCL_LINK_PWM        (1 << 0)    // Gate the LED with TCA0 WO1
+#define CCL_LINK_ACTIVE_LOW (1 << 1)    // LED is on when PF3 is low
+
+// Route the button to the LED on PF3 and start the link
+void ccl_link_init(uint8_t options);
+// Stop the link and release PF3, and TCA0 if the link started it
+void ccl_link_disable(void);
+
+#endif // CCL_LINK_H
@@ -1,25 +1,87 @@
 /*
  * File:   main.c
  * Author: Santeri Hiltunen
+ * 
+ * LED is on while the button is held down. The button interrupts on both
+ * edges and the ISR sets the LED, otherwise the CPU is in power-down.
+ * 
+ * With PUSHLED_HW_LINK set the button drives an external LED on PF3
+ * through the Event System and CCL instead (see ccl_link.h), and the CPU
+ * stays in power-down for good. PUSHLED_HW_LINK_PWM dims that LED with
+ * TCA0, which keeps the CPU in IDLE instead.
  *
  * Created on 09 November 2020, 14:22
  */
 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "ccl_link.h"
+
+// 1: link the button to a LED on PF3 in hardware, 0: PF5 LED from the ISR
+#ifndef PUSHLED_HW_LINK
+#define PUSHLED_HW_LINK 0
+#endif
+// 1: dim the hardware linked LED with TCA0 PWM
+#ifndef PUSHLED_HW_LINK_PWM
+#define PUSHLED_HW_LINK_PWM 0
+#endif
+
+// Set the LED to follow the button
+static inline void led_follow_button(void)
+{
+    if (VPORTF.IN & PIN6_bm) 
+    {
+        PORTF.OUTSET = PIN5_bm; // Button released, turn off LED
+    }
+    else 
+    {
+        PORTF.OUTCLR = PIN5_bm; // Button pressed, turn on LED
+    }
+}
 
 int main(void) 
 {
+#if PUSHLED_HW_LINK
+#if PUSHLED_HW_LINK_PWM
+    ccl_link_init(CCL_LINK_PWM);
+    
+    // Nothing will wake the CPU, IDLE keeps TCA0 running for the link
+    set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
+#else
+    ccl_link_init(0);
+    
+    // Nothing will wake the CPU, the link runs on its own
+    set_sleep_mode(SLPCTRL_SMODE_PDOWN_gc);
+#endif
+    cli();
+    while (1)
+    {
+        sleep_mode();
+    }
+#endif
+    
     PORTF.DIRSET = PIN5_bm; // Set PF5 (LED) as output
     PORTF.DIRCLR = PIN6_bm; // Set PF6 (switch) as input
+    
+    // PF6 is fully asynchronous, so both edges wake from power-down
+    PORTF.PIN6CTRL = PORT_ISC_BOTHEDGES_gc;
+    set_sleep_mode(SLPCTRL_SMODE_PDOWN_gc);
+    
+    led_follow_button();
+    sei();
+    
     while (1) 
     {
-        if (PORTF.IN & PIN6_bm) 
-        {
-            PORTF.OUTSET = PIN5_bm; // If button is pressed turn on LED
-        }
-        else {
-            PORTF.OUTCLR = PIN5_bm; // Else keep LED turned off
-        }
+        // All the work is done in the ISR
+        sleep_mode();
     }
 }
+
+ISR(PORTF_PORT_vect)
+{
+    // Clear the button interrupt flag
+    PORTF.INTFLAGS = PIN6_bm;
+    led_follow_button();
+}
@@ -3,6 +3,9 @@
  * 
  * A softly blinking LED implementation with a period of around 1 second
  * 
+ * The brightness is generated by TCA0 and stepped by its ramp interrupt,
+ * the CPU sleeps between the steps.
+ * 
  * Author: Santeri Hiltunen
  *
  * Created on 10 November 2020, 22:03
@@ -11,54 +14,26 @@
 #define F_CPU   3333333
 
 #include <avr/io.h>
-#include <util/delay.h>
-
-// Implements a single PWM cycle
-void pwm_period(unsigned int duty) 
-{
-    // Keeps the LED on for duty value times with a delay
-    for (unsigned int i = duty; i > 0x00; --i ) 
-    {
-        // Turn LED on
-        PORTF.OUTCLR = PIN5_bm;
-        _delay_us(7);
+#include <avr/interrupt.h>
+#include "pwm.h"
 
-    }
-    // Keeps the LED off for the remaining period (0xFF-duty) with a delay
-    for (unsigned int j = (0xFF-duty); j > 0x00; --j )
-    {
-        // Turn LED off
-        PORTF.OUTSET = PIN5_bm;
-        _delay_us(7);
-    }
-    
-
-}
+// 255 steps up and 255 down, 2 ticks each: 510 * 2 / 814 Hz = ~1.25 s
+#define BLINK_TICKS_PER_STEP    2
 
 int main(void) 
 {
-    // Set LED as output
-    PORTF.DIRSET = PIN5_bm;
-    
-    // Duty value determines the LED's brightness level
-    unsigned int duty = 0x00;
+    // Set LED as PWM output, starts off
+    pwm_init();
+    // Enable interrupts for the ramp steps
+    sei();
     
     while (1) 
     {   
-        // Increases duty value to max while calling PWM-function
-        while (duty < 0xFF)
-        {
-            ++duty;
-            pwm_period(duty);
-        }   
-        // Decreases duty value to min while calling PWM-function     
-        while (duty > 0x00)
-        {
-            --duty;
-            pwm_period(duty);
-        }   
-                
+        // Brighten to max and sleep while the timer does the steps
+        pwm_ramp(0xFF, BLINK_TICKS_PER_STEP);
+        pwm_wait();
+        // Dim back to min the same way
+        pwm_ramp(0x00, BLINK_TICKS_PER_STEP);
+        pwm_wait();
     }
 }
-
-
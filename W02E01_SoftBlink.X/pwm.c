@@ -0,0 +1,121 @@
+/* 
+ * File: pwm.c
+ * Hardware PWM on the LED (PF5) using TCA0, see pwm.h.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "pwm.h"
+
+// Brightness the ramp is heading to
+static volatile uint8_t ramp_target;
+// Ramp ticks per brightness step and ticks left until the next step
+static volatile uint8_t ramp_ticks;
+static volatile uint8_t ramp_count;
+
+void pwm_init(void)
+{
+    // The LED is active-low, invert PF5 so a higher duty is brighter
+    PORTF.PIN5CTRL = PORT_INVEN_bm;
+    PORTF.DIRSET = PIN5_bm;
+    
+    // Route TCA0 waveform outputs to port F, WO5 is PF5
+    PORTMUX.TCAROUTEA = PORTMUX_TCA0_PORTF_gc;
+    
+    TCA0.SPLIT.CTRLD = TCA_SPLIT_SPLITM_bm;
+    TCA0.SPLIT.CTRLB = TCA_SPLIT_HCMP2EN_bm;
+    // A compare value above HPER keeps the output on the whole period
+    TCA0.SPLIT.HPER = 0xFE;
+    TCA0.SPLIT.LPER = 0xFF;
+    TCA0.SPLIT.HCMP2 = 0x00;
+    TCA0.SPLIT.CTRLA = TCA_SPLIT_CLKSEL_DIV16_gc | TCA_SPLIT_ENABLE_bm;
+}
+
+void pwm_set_duty(uint8_t duty)
+{
+    pwm_stop();
+    TCA0.SPLIT.HCMP2 = duty;
+}
+
+uint8_t pwm_get_duty(void)
+{
+    return TCA0.SPLIT.HCMP2;
+}
+
+void pwm_ramp(uint8_t target, uint8_t ticks_per_step)
+{
+    if (ticks_per_step == 0)
+    {
+        ticks_per_step = 1;
+    }
+    
+    pwm_stop();
+    ramp_target = target;
+    ramp_ticks = ticks_per_step;
+    ramp_count = ticks_per_step;
+    
+    if (TCA0.SPLIT.HCMP2 != target)
+    {
+        TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LUNF_bm;
+        TCA0.SPLIT.INTCTRL = TCA_SPLIT_LUNF_bm;
+    }
+}
+
+void pwm_stop(void)
+{
+    TCA0.SPLIT.INTCTRL = 0;
+}
+
+uint8_t pwm_ramping(void)
+{
+    return TCA0.SPLIT.INTCTRL & TCA_SPLIT_LUNF_bm;
+}
+
+void pwm_wait(void)
+{
+    set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
+    
+    // Check with interrupts disabled so the last step can't slip in
+    // between the check and going to sleep
+    cli();
+    while (pwm_ramping())
+    {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    sei();
+}
+
+// Ramp tick, one brightness step every ramp_ticks underflows
+ISR(TCA0_LUNF_vect)
+{
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LUNF_bm;
+    
+    if (--ramp_count)
+    {
+        return;
+    }
+    ramp_count = ramp_ticks;
+    
+    uint8_t duty = TCA0.SPLIT.HCMP2;
+    
+    if (duty < ramp_target)
+    {
+        ++duty;
+    }
+    else if (duty > ramp_target)
+    {
+        --duty;
+    }
+    TCA0.SPLIT.HCMP2 = duty;
+    
+    // Target reached, stop waking up for ticks
+    if (duty == ramp_target)
+    {
+        TCA0.SPLIT.INTCTRL = 0;
+    }
+}
@@ -0,0 +1,47 @@
+/* 
+ * File: pwm.h
+ * Hardware PWM on the LED (PF5) using TCA0.
+ * 
+ * TCA0 runs in split mode: the high half generates the PWM on WO5, which
+ * PORTMUX routes to PF5, and the low half underflows at PWM_TICK_HZ to
+ * drive brightness ramps. The 16-bit single-slope mode only has outputs on
+ * WO0-WO2, which can't reach PF5 on this board.
+ * 
+ * The timer doesn't run in standby, so sleep in IDLE while the LED is lit.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 3333333
+#endif
+
+// TCA0 prescaler, both halves count CLK_PER / 16
+#define PWM_PRESCALER   16
+// PWM frequency, HPER = 0xFE gives 255 steps: ~817 Hz
+#define PWM_HZ          (F_CPU / PWM_PRESCALER / 255)
+// Ramp tick frequency, LPER = 0xFF: ~814 Hz
+#define PWM_TICK_HZ     (F_CPU / PWM_PRESCALER / 256)
+
+// Start TCA0 and drive PF5 with the LED off
+void pwm_init(void);
+// Set brightness immediately (0x00 off .. 0xFF fully on), stops any ramp
+void pwm_set_duty(uint8_t duty);
+// Current brightness
+uint8_t pwm_get_duty(void);
+/*
+ * Move the brightness one step towards target every ticks_per_step ramp
+ * ticks (at least 1). Runs from the timer interrupt.
+ */
+void pwm_ramp(uint8_t target, uint8_t ticks_per_step);
+// Stop a ramp and keep the current brightness
+void pwm_stop(void);
+// Nonzero while a ramp is in progress
+uint8_t pwm_ramping(void);
+// Sleep until the ramp in progress has finished
+void pwm_wait(void);
+
+#endif // PWM_H
@@ -0,0 +1,112 @@
+/* 
+ * File: button.c
+ * Debounced button on PF6, see button.h.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "button.h"
+
+// Debounced state, nonzero when held down
+static volatile uint8_t pressed = 0;
+// Set when the debounced state changes, cleared by button_changed()
+static volatile uint8_t changed = 0;
+// Samples in a row that differed from the debounced state
+static uint8_t debounce = 0;
+
+static void sampling_start(void);
+static void sampling_stop(void);
+static inline void sample(void);
+
+void button_init(void)
+{
+    // PIT ticks come from the internal 32.768 kHz oscillator
+    while (RTC.STATUS > 0);
+    RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
+    
+    // Set button as input
+    PORTF.DIRCLR = PIN6_bm;
+    // Btn triggers an interrupt on falling edge
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_FALLING_gc;
+}
+
+uint8_t button_held(void)
+{
+    return pressed;
+}
+
+uint8_t button_changed(void)
+{
+    uint8_t c = changed;
+    
+    changed = 0;
+    return c;
+}
+
+// Hand the pin over from the edge interrupt to the PIT
+static void sampling_start(void)
+{
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_INTDISABLE_gc;
+    
+    while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+    RTC.PITINTFLAGS = RTC_PI_bm;
+    RTC.PITINTCTRL = RTC_PI_bm;
+    RTC.PITCTRLA = RTC_PERIOD_CYC256_gc | RTC_PITEN_bm;
+}
+
+// Back to waiting for a press without any periodic wakeups
+static void sampling_stop(void)
+{
+    while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+    RTC.PITCTRLA = 0;
+    RTC.PITINTCTRL = 0;
+    
+    PORTF.INTFLAGS = PIN6_bm;
+    PORTF.PIN6CTRL = (PORTF.PIN6CTRL & ~PORT_ISC_gm) | PORT_ISC_FALLING_gc;
+    
+    // A press while the edge interrupt was off has no edge left to see
+    if (!(VPORTF.IN & PIN6_bm))
+    {
+        sampling_start();
+    }
+}
+
+// Triggered on a button press, possibly by contact bounce
+ISR(PORTF_PORT_vect)
+{
+    // Clear the interrupt flag
+    PORTF.INTFLAGS = PIN6_bm;
+    sampling_start();
+}
+
+// Button sample tick while the button is in use
+ISR(RTC_PIT_vect)
+{
+    RTC.PITINTFLAGS = RTC_PI_bm;
+    sample();
+}
+
+// Debounce one sample and flag the changes for the main loop
+static inline void sample(void)
+{
+    // Btn pulls the pin low
+    uint8_t level = !(VPORTF.IN & PIN6_bm);
+    
+    if (level != pressed)
+    {
+        // Wait for the level to settle before accepting the change
+        if (++debounce < BUTTON_DEBOUNCE_TICKS)
+        {
+            return;
+        }
+        pressed = level;
+        changed = 1;
+    }
+    debounce = 0;
+    
+    if (!pressed)
+    {
+        // Released and settled, or the edge was only a glitch
+        sampling_stop();
+    }
+}
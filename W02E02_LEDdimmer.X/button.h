@@ -0,0 +1,32 @@
+/* 
+ * File: button.h
+ * Debounced button on PF6.
+ * 
+ * Same scheme as in RetirementClock: a falling edge on the pin starts
+ * sampling it with the RTC PIT, and the level must read the same for
+ * BUTTON_DEBOUNCE_TICKS samples to count as a press or release. Once
+ * released, the PIT is stopped and the pin interrupt waits for the next
+ * press. Contact bounce never reaches the caller.
+ */
+
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+
+// Sample rate: RTC clock / 256 = 128 Hz, 7.8 ms per tick
+#define BUTTON_TICK_HZ          128
+// Ticks the level must be stable for, ~23 ms
+#define BUTTON_DEBOUNCE_TICKS   3
+
+// Set PF6 up as the button input and the RTC clock for the PIT
+void button_init(void);
+// Nonzero while the debounced button is held down
+uint8_t button_held(void);
+/*
+ * Nonzero once after every debounced press and release. Call with
+ * interrupts disabled to check it before going to sleep.
+ */
+uint8_t button_changed(void);
+
+#endif // BUTTON_H
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Generates gamma_table.h, the brightness level -> PWM duty lookup table of
+the LED dimmer, and checks it before writing.
+
+    duty(level) = round(top * (level / (levels - 1)) ** gamma)
+
+The default top, 4080, is 255 PWM counts with 4 dithered bits below them.
+Each level is forced at least one count above the previous one, so every
+step at the dark end still changes the duty. The table is checked for
+strictly increasing values and duty(0) == 0, duty(levels - 1) == top.
+
+    python3 gamma.py [-g GAMMA] [-n LEVELS] [-t TOP] [-o gamma_table.h]
+    python3 gamma.py --check gamma_table.h
+"""
+
+import argparse
+import re
+import sys
+
+
+def generate(gamma, levels, top):
+    table = []
+    for level in range(levels):
+        duty = round(top * (level / (levels - 1)) ** gamma)
+        if table and duty <= table[-1]:
+            duty = table[-1] + 1
+        table.append(duty)
+    return table
+
+
+def check(table, top):
+    errors = []
+    if len(table) < 2:
+        errors.append("table needs at least 2 levels")
+        return errors
+    if table[0] != 0:
+        errors.append("first level is %d, expected 0" % table[0])
+    if table[-1] != top:
+        errors.append("last level is %d, expected %d" % (table[-1], top))
+    for level in range(1, len(table)):
+        if table[level] <= table[level - 1]:
+            errors.append("level %d (%d) not above level %d (%d)"
+                          % (level, table[level], level - 1, table[level - 1]))
+    if top > 0xFFFF:
+        errors.append("top %d doesn't fit 16 bits" % top)
+    return errors
+
+
+def render(table, gamma, top):
+    lines = [
+        "/* ",
+        " * File: gamma_table.h",
+        " * Generated by gamma.py, don't edit. Brightness level -> PWM duty,",
+        " * gamma %g, %d levels, duty 0..%d." % (gamma, len(table), top),
+        " */",
+        "",
+        "#ifndef GAMMA_TABLE_H",
+        "#define GAMMA_TABLE_H",
+        "",
+        "#include <stdint.h>",
+        "#include <avr/pgmspace.h>",
+        "",
+        "#define GAMMA_LEVELS    %d" % len(table),
+        "#define GAMMA_TOP       %d" % top,
+        "",
+        "static const uint16_t gamma_table[GAMMA_LEVELS] PROGMEM =",
+        "{",
+    ]
+    for i in range(0, len(table), 8):
+        row = ", ".join("%5d" % v for v in table[i:i + 8])
+        lines.append("    " + row + ("," if i + 8 < len(table) else ""))
+    lines += ["};", "", "#endif // GAMMA_TABLE_H", ""]
+    return "\n".join(lines)
+
+
+def parse(path):
+    text = open(path).read()
+    top = int(re.search(r"#define GAMMA_TOP\s+(\d+)", text).group(1))
+    body = text[text.index("{") + 1:text.index("}")]
+    return [int(v) for v in re.findall(r"\d+", body)], top
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument("-g", "--gamma", type=float, default=2.2)
+    parser.add_argument("-n", "--levels", type=int, default=256)
+    parser.add_argument("-t", "--top", type=int, default=4080)
+    parser.add_argument("-o", "--output", default="gamma_table.h")
+    parser.add_argument("--check", metavar="HEADER",
+                        help="only check an existing table header")
+    args = parser.parse_args()
+
+    if args.check:
+        table, top = parse(args.check)
+    else:
+        table, top = generate(args.gamma, args.levels, args.top), args.top
+
+    errors = check(table, top)
+    for error in errors:
+        print("gamma.py: %s" % error, file=sys.stderr)
+    if errors:
+        return 1
+
+    if not args.check:
+        with open(args.output, "w") as f:
+            f.write(render(table, args.gamma, top))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -5,6 +5,10 @@
  * every time the button is pressed down. Keeps the brightness state
  * when button is not pressed
  * 
+ * The brightness is generated by TCA0 and stepped by its ramp interrupt
+ * through a gamma curve, so the steps look even at the dark end too.
+ * Debounced button presses and releases wake the CPU, otherwise it sleeps.
+ * 
  * Author: Santeri Hiltunen
  *
  * Created on 11 November 2020, 14:53
@@ -14,77 +18,65 @@
 #define F_CPU   3333333
 
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "button.h"
+#include "pwm.h"
 
-// Implements a single PWM cycle
-void pwm_period(unsigned int duty) 
-{
-    // Keeps the LED on for duty value times with a delay
-    for (unsigned int i = duty; i > 0x00; --i ) 
-    {
-        // Turn LED on
-        PORTF.OUTCLR = PIN5_bm;
-        _delay_us(7);
-
-    }
-    // Keeps the LED off for the remaining period (0xFF-duty) with a delay
-    for (unsigned int j = (0xFF-duty); j > 0x00; --j )
-    {
-        // Turn LED off
-        PORTF.OUTSET = PIN5_bm;
-        _delay_us(7);
-    } 
-}
+// Full range in 255 * 2 / 817 Hz = ~0.6 s while the btn is held down
+#define DIM_TICKS_PER_STEP  2
 
 int main(void) 
 {
-    // Set LED as output
-    PORTF.DIRSET = PIN5_bm;
+    // Set LED as PWM output, starts off
+    pwm_init();
+    
+    // Set button as input, debounced by the RTC PIT
+    button_init();
     
-    // Set button as input
-    PORTF.DIRCLR = PIN6_bm;
+    // PWM needs the timer running, so only idle
+    set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
+    sei();
     
-    // Controls LED brightness: 0x00 == MIN, 0xFF == MAX
-    unsigned int duty = 0x00;
+    // Btn state last acted on
+    uint8_t pressed = 0;
     
     // Shows whether the LED should be dimming or brightening 
-    unsigned int btnDIM = 0;
+    uint8_t btnDIM = 0;
 
     while (1) 
     {   
-        // Checks if the btn is pressed
-        if (!(PORTF.IN & PIN6_bm)) 
+        // Sleep until the btn changes, checked with interrupts disabled
+        // so a change can't slip in just before sleeping
+        cli();
+        if (!button_changed())
         {
-            // Brightening sequence keeps checking if the btn is held down
-            while (!(PORTF.IN & PIN6_bm) && !btnDIM)
-            {
-                // Increases brightness to MAX without going over
-                if (duty < 0xFF)
-                {
-                    ++duty;
-                }
-                pwm_period(duty);
-            }
-            // Dimming sequence keeps checking if the btn is held down
-            while (!(PORTF.IN & PIN6_bm) && btnDIM)
-            {
-                // Decreases brightness to MIN without going under
-                if (duty > 0x00)
-                {
-                    --duty;
-                }
-                pwm_period(duty);
-            }
-            // Flips the state variable for the next btn press sequence
-            btnDIM = !btnDIM;
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+            continue;
         }
+        sei();
         
-        // Keeps the current brightness level when btn is not pressed
-        else 
+        uint8_t now = button_held();
+        if (now == pressed)
         {
-            pwm_period(duty);
+            continue;
         }
+        pressed = now;
         
+        if (pressed)
+        {
+            // Ramp towards MIN or MAX while the btn is held down
+            pwm_ramp(btnDIM ? 0 : PWM_MAX_LEVEL, DIM_TICKS_PER_STEP);
+        }
+        else
+        {
+            // Keep the current brightness and flip the state variable
+            // for the next btn press sequence
+            pwm_stop();
+            btnDIM = !btnDIM;
+        }
     }
-
 }
@@ -0,0 +1,195 @@
+/* 
+ * File: pwm.c
+ * Gamma-corrected, dithered hardware PWM on the LED (PF5), see pwm.h.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "pwm.h"
+
+#if GAMMA_LEVELS > 256
+#error "Brightness levels must fit in uint8_t, regenerate gamma_table.h"
+#endif
+
+#define DITHER_MASK ((1 << PWM_DITHER_BITS) - 1)
+
+// Current brightness level and the one a ramp is heading to
+static volatile uint8_t level_now;
+static volatile uint8_t ramp_target;
+// Nonzero while ramping
+static volatile uint8_t ramp_on;
+// PWM periods per level step and periods left until the next step
+static volatile uint8_t ramp_ticks;
+static volatile uint8_t ramp_count;
+// Whole compare counts and dithered fraction of the current duty
+static volatile uint8_t duty_base;
+static volatile uint8_t duty_frac;
+// Fraction carried between periods, only used by the interrupt
+static uint8_t dither_acc;
+
+static void load_duty(uint16_t duty);
+static void update_interrupt(void);
+
+void pwm_init(void)
+{
+    // The LED is active-low, invert PF5 so a higher duty is brighter
+    PORTF.PIN5CTRL = PORT_INVEN_bm;
+    PORTF.DIRSET = PIN5_bm;
+    
+    // Route TCA0 waveform outputs to port F, WO5 is PF5
+    PORTMUX.TCAROUTEA = PORTMUX_TCA0_PORTF_gc;
+    
+    TCA0.SPLIT.CTRLD = TCA_SPLIT_SPLITM_bm;
+    TCA0.SPLIT.CTRLB = TCA_SPLIT_HCMP2EN_bm;
+    // A compare value above HPER keeps the output on the whole period
+    TCA0.SPLIT.HPER = 0xFE;
+    TCA0.SPLIT.HCMP2 = 0x00;
+    TCA0.SPLIT.CTRLA = TCA_SPLIT_CLKSEL_DIV16_gc | TCA_SPLIT_ENABLE_bm;
+}
+
+// Split a duty into compare counts and fraction. Interrupts must be off
+static void load_duty(uint16_t duty)
+{
+    duty_base = duty >> PWM_DITHER_BITS;
+    duty_frac = duty & DITHER_MASK;
+}
+
+// Only take period interrupts while there is something to do in them
+static void update_interrupt(void)
+{
+    if (ramp_on || duty_frac)
+    {
+        if (!(TCA0.SPLIT.INTCTRL & TCA_SPLIT_HUNF_bm))
+        {
+            TCA0.SPLIT.INTFLAGS = TCA_SPLIT_HUNF_bm;
+            TCA0.SPLIT.INTCTRL = TCA_SPLIT_HUNF_bm;
+        }
+    }
+    else
+    {
+        TCA0.SPLIT.INTCTRL = 0;
+        TCA0.SPLIT.HCMP2 = duty_base;
+    }
+}
+
+void pwm_set_duty(uint16_t duty)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ramp_on = 0;
+        load_duty(duty);
+        TCA0.SPLIT.HCMP2 = duty_base;
+        update_interrupt();
+    }
+}
+
+void pwm_set_level(uint8_t level)
+{
+#if GAMMA_LEVELS < 256
+    if (level > PWM_MAX_LEVEL)
+    {
+        level = PWM_MAX_LEVEL;
+    }
+#endif
+    pwm_set_duty(pgm_read_word(&gamma_table[level]));
+    level_now = level;
+}
+
+uint8_t pwm_get_level(void)
+{
+    return level_now;
+}
+
+void pwm_ramp(uint8_t target, uint8_t ticks_per_step)
+{
+#if GAMMA_LEVELS < 256
+    if (target > PWM_MAX_LEVEL)
+    {
+        target = PWM_MAX_LEVEL;
+    }
+#endif
+    if (ticks_per_step == 0)
+    {
+        ticks_per_step = 1;
+    }
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ramp_target = target;
+        ramp_ticks = ticks_per_step;
+        ramp_count = ticks_per_step;
+        ramp_on = (level_now != target);
+        update_interrupt();
+    }
+}
+
+void pwm_stop(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ramp_on = 0;
+        update_interrupt();
+    }
+}
+
+uint8_t pwm_ramping(void)
+{
+    return ramp_on;
+}
+
+void pwm_wait(void)
+{
+    set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
+    
+    // Check with interrupts disabled so the last step can't slip in
+    // between the check and going to sleep
+    cli();
+    while (ramp_on)
+    {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    sei();
+}
+
+// Start of a PWM period: step the ramp, dither the duty of this period
+ISR(TCA0_HUNF_vect)
+{
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_HUNF_bm;
+    
+    if (ramp_on && !--ramp_count)
+    {
+        uint8_t level = level_now;
+        
+        ramp_count = ramp_ticks;
+        if (level < ramp_target)
+        {
+            ++level;
+        }
+        else
+        {
+            --level;
+        }
+        level_now = level;
+        load_duty(pgm_read_word(&gamma_table[level]));
+        if (level == ramp_target)
+        {
+            ramp_on = 0;
+        }
+    }
+    
+    // One count more whenever the accumulated fraction carries over.
+    // The compare isn't buffered, but the counter has just been reloaded
+    // from HPER so the new value is still ahead of it
+    dither_acc += duty_frac;
+    TCA0.SPLIT.HCMP2 = duty_base + (dither_acc >> PWM_DITHER_BITS);
+    dither_acc &= DITHER_MASK;
+    
+    update_interrupt();
+}
@@ -0,0 +1,65 @@
+/* 
+ * File: pwm.h
+ * Gamma-corrected PWM on the LED (PF5) using TCA0.
+ * 
+ * TCA0 runs in split mode like in SoftBlink: the high half generates an
+ * 8-bit PWM on WO5, which PORTMUX routes to PF5, so the LED is switched
+ * by hardware. Duties have PWM_DITHER_BITS more resolution than that. The
+ * fraction is added by temporal dithering: at each PWM period start (the
+ * high half underflow) an accumulator decides whether this period gets one
+ * count more, which spreads the extra counts evenly over 16 periods.
+ * 
+ * Brightness is set in perceptual levels 0..GAMMA_LEVELS-1, mapped to duty
+ * by gamma_table.h (generated by gamma.py). Ramps step one level every
+ * given number of PWM periods from the same interrupt. The interrupt is
+ * only enabled while ramping or while the duty has a fraction to dither.
+ * 
+ * The timer doesn't run in standby, so sleep in IDLE while the LED is lit.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include <stdint.h>
+#include "gamma_table.h"
+
+#ifndef F_CPU
+#define F_CPU 3333333
+#endif
+
+// TCA0 prescaler, the high half counts CLK_PER / 16
+#define PWM_PRESCALER   16
+// PWM frequency, HPER = 0xFE gives 255 steps: ~817 Hz
+#define PWM_HZ          (F_CPU / PWM_PRESCALER / 255)
+// Ramps are stepped once per PWM period
+#define PWM_TICK_HZ     PWM_HZ
+// Duty bits below the 8-bit hardware compare, dithered
+#define PWM_DITHER_BITS 4
+// Brightest level
+#define PWM_MAX_LEVEL   (GAMMA_LEVELS - 1)
+
+#if GAMMA_TOP != (255 << PWM_DITHER_BITS)
+#error "gamma_table.h must end at 255 << PWM_DITHER_BITS, see GAMMA_TOP in Makefile"
+#endif
+
+// Start TCA0 and drive PF5 with the LED off
+void pwm_init(void);
+// Set the raw duty (0..GAMMA_TOP) immediately, stops any ramp
+void pwm_set_duty(uint16_t duty);
+// Set brightness level (0..PWM_MAX_LEVEL) immediately, stops any ramp
+void pwm_set_level(uint8_t level);
+// Current brightness level
+uint8_t pwm_get_level(void);
+/*
+ * Move the brightness one level towards target every ticks_per_step PWM
+ * periods (at least 1). Runs from the timer interrupt.
+ */
+void pwm_ramp(uint8_t target, uint8_t ticks_per_step);
+// Stop a ramp and keep the current brightness
+void pwm_stop(void);
+// Nonzero while a ramp is in progress
+uint8_t pwm_ramping(void);
+// Sleep until the ramp in progress has finished
+void pwm_wait(void);
+
+#endif // PWM_H
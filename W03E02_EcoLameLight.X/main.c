@@ -2,7 +2,8 @@
  * File:   main.c
  * 
  * Turns on the LED whenever the button is pressed down.
- * CPU stays in sleep mode unless it's interrupted by a button press.
+ * CPU stays in sleep mode unless it's interrupted by a button press
+ * or release, the ISR sets the LED and the CPU goes straight back to sleep.
  * 
  * Author: Santeri Hiltunen
  *
@@ -16,26 +17,27 @@
 
 int main(void) 
 {
-    // Set LED as output
+    // Set LED as output, starts off
+    PORTF.OUTSET = PIN5_bm;
     PORTF.DIRSET = PIN5_bm;
     // Set btn as input
     PORTF.DIRCLR = PIN6_bm; 
     
-    // Btn is configured to trigger an interrupt when pressed
-    PORTF.PIN6CTRL = PORT_ISC_FALLING_gc;
+    // Btn is configured to trigger an interrupt when pressed and released
+    PORTF.PIN6CTRL = PORT_ISC_BOTHEDGES_gc;
+    // PF6 is fully asynchronous and wakes the CPU from the deepest sleep
+    set_sleep_mode(SLPCTRL_SMODE_PDOWN_gc);
+    
+    // Btn may already be held down at startup
+    if (!(VPORTF.IN & PIN6_bm))
+    {
+        PORTF.OUTCLR = PIN5_bm;
+    }
     // Enable interrupts
     sei();
     
     while (1) 
     {
-        // LED will stay on for as long as the btn is pressed
-        // after returning from the ISR
-        while (!(PORTF.IN & PIN6_bm)) 
-        {
-            PORTF.OUTCLR = PIN5_bm;
-        }
-        // Turn LED off as soon as the btn is released
-        PORTF.OUTSET = PIN5_bm;
         // Enter sleep mode after each interrupt
         sleep_mode();
     }
@@ -43,6 +45,16 @@ int main(void)
 
 ISR(PORTF_PORT_vect)
 {
-    // Clear all interrupt flags
-    PORTF.INTFLAGS = 0xFF;
+    // Clear the btn interrupt flag
+    PORTF.INTFLAGS = PIN6_bm;
+    
+    // LED is on for as long as the btn is pressed
+    if (VPORTF.IN & PIN6_bm)
+    {
+        PORTF.OUTSET = PIN5_bm;
+    }
+    else
+    {
+        PORTF.OUTCLR = PIN5_bm;
+    }
 }